@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Generator.hpp"
+#include "../include/Lexer.hpp"
+#include "../include/Parser.hpp"
+#include "../include/Stats.hpp"
+#include "../include/WorkerPool.hpp"
+
+#ifndef AGSCRIPT_STATS
+#error "the benchmark reads node and allocation counts from Stats; build with -DAGSCRIPT_STATS"
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+struct Summary {
+    double min;
+    double median;
+    double mean;
+    double stddev;
+};
+
+static Summary summarize(std::vector<double> seconds) {
+    std::sort(seconds.begin(), seconds.end());
+    double sum = 0;
+    for (double s : seconds) sum += s;
+    double mean = sum / seconds.size();
+    double variance = 0;
+    for (double s : seconds) variance += (s - mean) * (s - mean);
+
+    size_t mid = seconds.size() / 2;
+    double median = seconds.size() % 2 ? seconds[mid] : (seconds[mid - 1] + seconds[mid]) / 2;
+    return Summary{seconds.front(), median, mean, std::sqrt(variance / seconds.size())};
+}
+
+template <typename Work>
+static Summary measure(int runs, Work work) {
+    work(); // warm-up, not recorded
+    std::vector<double> seconds;
+    for (int i = 0; i < runs; i++) {
+        auto start = Clock::now();
+        work();
+        seconds.push_back(std::chrono::duration<double>(Clock::now() - start).count());
+    }
+    return summarize(seconds);
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    std::vector<Token> tokens;
+    Lexer lexer(source);
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+static size_t total_nodes() {
+    size_t total = 0;
+    for (size_t i = 0; i < (size_t)NodeKind::COUNT; i++) total += Stats::nodes((NodeKind)i);
+    return total;
+}
+
+// Results are flat "shape.metric" keys so they diff cleanly against a baseline.
+using Results = std::map<std::string, double>;
+
+// With a pool, parse_parallel is measured on it as well.
+static void run_shape(Shape shape, uint32_t seed, size_t size, int runs, WorkerPool* pool, Results& results) {
+    const std::string prefix = std::string(shape_name(shape)) + ".";
+    const std::string source = Generator(shape, seed).generate(size);
+    const std::vector<Token> tokens = lex(source);
+
+    Summary lexing = measure(runs, [&]() { lex(source); });
+    results[prefix + "lex_bytes_per_sec"] = source.size() / lexing.median;
+    results[prefix + "lex_tokens_per_sec"] = tokens.size() / lexing.median;
+    results[prefix + "lex_stddev_pct"] = 100 * lexing.stddev / lexing.mean;
+
+    size_t nodesBefore = total_nodes();
+    size_t allocationsBefore = Stats::allocations();
+    {
+        Parser parser(tokens);
+        parser.parse();
+    }
+    size_t nodes = total_nodes() - nodesBefore;
+    results[prefix + "parse_nodes"] = nodes;
+    results[prefix + "parse_allocations"] = Stats::allocations() - allocationsBefore;
+
+    Summary parsing = measure(runs, [&]() { Parser(tokens).parse(); });
+    results[prefix + "parse_nodes_per_sec"] = nodes / parsing.median;
+    results[prefix + "parse_stddev_pct"] = 100 * parsing.stddev / parsing.mean;
+
+    if (pool) {
+        Summary parallel = measure(runs, [&]() { Parser::parse_parallel(tokens, *pool); });
+        results[prefix + "parse_parallel_nodes_per_sec"] = nodes / parallel.median;
+        results[prefix + "parse_parallel_stddev_pct"] = 100 * parallel.stddev / parallel.mean;
+    }
+
+    // No interpreter exists yet, so end-to-end stops after parsing.
+    Summary total = measure(runs, [&]() { Parser(lex(source)).parse(); });
+    results[prefix + "end_to_end_ms"] = total.median * 1e3;
+    results[prefix + "end_to_end_min_ms"] = total.min * 1e3;
+}
+
+static void write_json(std::ostream& out, const Results& results, uint32_t seed, size_t size, int runs) {
+    out << "{\n  \"seed\": " << seed << ",\n  \"size\": " << size << ",\n  \"runs\": " << runs << ",\n  \"results\": {\n";
+    const char* separator = "";
+    for (const auto& entry : results) {
+        out << separator << "    \"" << entry.first << "\": " << std::fixed << entry.second;
+        separator = ",\n";
+    }
+    out << "\n  }\n}\n";
+}
+
+// Reads back the "results" object written by write_json.
+static bool read_json(const std::string& path, Results& results) {
+    std::ifstream file(path);
+    if (!file) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    size_t at = text.find("\"results\"");
+    if (at == std::string::npos) return false;
+    while ((at = text.find('"', at + 1)) != std::string::npos) {
+        size_t close = text.find('"', at + 1);
+        size_t colon = text.find(':', close);
+        if (close == std::string::npos || colon == std::string::npos) break;
+        results[text.substr(at + 1, close - at - 1)] = std::strtod(text.c_str() + colon + 1, nullptr);
+        at = text.find_first_of(",}", colon);
+        if (at == std::string::npos || text[at] == '}') break;
+    }
+    return true;
+}
+
+// Throughput metrics regress when they drop, timings when they grow.
+static int compare(const Results& current, const Results& baseline, double threshold) {
+    int regressions = 0;
+    for (const auto& entry : baseline) {
+        auto it = current.find(entry.first);
+        if (it == current.end() || entry.second == 0) continue;
+
+        bool higherIsBetter = entry.first.find("_per_sec") != std::string::npos;
+        bool timing = entry.first.find("_ms") != std::string::npos;
+        if (!higherIsBetter && !timing) continue;
+
+        double change = 100 * (it->second - entry.second) / entry.second;
+        bool regressed = (higherIsBetter && change < -threshold) || (timing && change > threshold);
+
+        std::cout << (regressed ? "REGRESSION " : "           ") << entry.first << ": "
+                  << std::showpos << std::fixed << std::setprecision(1) << change << "%" << std::noshowpos << "\n";
+        regressions += regressed;
+    }
+    return regressions;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t seed = 1;
+    size_t size = 1 << 20;
+    int runs = 10;
+    double threshold = 5;
+    std::string out;
+    std::string baseline;
+    std::string emit;
+    std::vector<Shape> shapes;
+    unsigned threads = 0;
+
+    auto usage = [&]() {
+        std::cerr << "Usage: " << argv[0] << " [--seed N] [--size BYTES] [--runs N] [--out FILE]"
+                  << " [--threads N] [--baseline FILE] [--threshold PCT] [--emit SHAPE] [SHAPE...]\n";
+        return 1;
+    };
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << "\n";
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        // std::stoul and friends throw invalid_argument or out_of_range,
+        // both logic_errors, on a bad number.
+        try {
+            if (arg == "--seed") { seed = std::stoul(value()); continue; }
+            if (arg == "--size") { size = std::stoul(value()); continue; }
+            if (arg == "--runs") { runs = std::max(1, std::stoi(value())); continue; }
+            if (arg == "--threshold") { threshold = std::stod(value()); continue; }
+            if (arg == "--threads") { threads = std::stoul(value()); continue; }
+        } catch (const std::logic_error&) {
+            std::cerr << "Invalid value for " << arg << ": " << argv[i] << "\n";
+            return usage();
+        }
+
+        if (arg == "--out") out = value();
+        else if (arg == "--baseline") baseline = value();
+        else if (arg == "--emit") emit = value();
+        else {
+            Shape shape;
+            if (!parse_shape(arg, shape)) return usage();
+            shapes.push_back(shape);
+        }
+    }
+
+    // Write one generated program and exit, e.g. to feed the driver.
+    if (!emit.empty()) {
+        Shape shape;
+        if (!parse_shape(emit, shape)) {
+            std::cerr << "Unknown shape: " << emit << "\n";
+            return 1;
+        }
+        std::cout << Generator(shape, seed).generate(size);
+        return 0;
+    }
+
+    if (shapes.empty()) {
+        for (size_t i = 0; i < (size_t)Shape::COUNT; i++) shapes.push_back((Shape)i);
+    }
+
+    // parse_parallel's calling thread works too, so N threads is N - 1 workers.
+    std::unique_ptr<WorkerPool> pool;
+    if (threads > 1) pool = std::make_unique<WorkerPool>(threads - 1);
+
+    Results results;
+    for (Shape shape : shapes) {
+        run_shape(shape, seed, size, runs, pool.get(), results);
+    }
+
+    write_json(std::cout, results, seed, size, runs);
+    if (!out.empty()) {
+        std::ofstream file(out);
+        write_json(file, results, seed, size, runs);
+    }
+
+    if (!baseline.empty()) {
+        Results previous;
+        if (!read_json(baseline, previous)) {
+            std::cerr << "Could not read baseline: " << baseline << "\n";
+            return 1;
+        }
+        return compare(results, previous, threshold) ? 2 : 0;
+    }
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "Generator.hpp"
+
+static const char* shapeNames[] = {"expressions", "nested", "functions", "strings"};
+
+const char* shape_name(Shape shape) {
+    return shapeNames[(size_t)shape];
+}
+
+bool parse_shape(const std::string& name, Shape& shape) {
+    for (size_t i = 0; i < (size_t)Shape::COUNT; i++) {
+        if (name == shapeNames[i]) {
+            shape = (Shape)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string Generator::generate(size_t bytes) {
+    std::string out;
+    out.reserve(bytes + 4096);
+    while (out.size() < bytes) {
+        switch (shape) {
+            case Shape::EXPRESSIONS: expressions(out); break;
+            case Shape::NESTED: nested(out); break;
+            case Shape::FUNCTIONS: functions(out); break;
+            case Shape::STRINGS: strings(out); break;
+            case Shape::COUNT: return out;
+        }
+    }
+    return out;
+}
+
+// Identifiers are letters only: the lexer splits names at digits. The
+// prefixes keep them clear of every keyword.
+std::string Generator::name(const char* prefix) {
+    std::string id = prefix;
+    size_t n = names++;
+    do {
+        id.push_back('a' + n % 26);
+        n /= 26;
+    } while (n);
+    return id;
+}
+
+std::string Generator::expression(int depth) {
+    if (depth <= 0 || pick(4) == 0) {
+        switch (pick(4)) {
+            case 0: return std::to_string(rng() % 100000);
+            case 1: return pick(2) ? "true" : "null";
+            case 2: return "\"" + std::string(1 + pick(12), 'x') + "\"";
+            default: return "va";
+        }
+    }
+
+    // Operands are generated into locals: the evaluation order of the two
+    // sides of `+` is unspecified and would make the output compiler-specific.
+    size_t form = pick(5);
+    std::string left = expression(depth - 1);
+    switch (form) {
+        case 0: return "(" + left + ")";
+        case 1: return "-" + left;
+        default: break;
+    }
+    std::string right = expression(depth - 1);
+    switch (form) {
+        case 2: return left + " == " + right;
+        case 3: return left + " - " + right;
+        default: return left + " + " + right;
+    }
+}
+
+std::string Generator::string_literal(size_t length) {
+    static const char alphabet[] = "abcdefghijklmnopqrstuvwxyz ABCDEFGHIJKLMNOPQRSTUVWXYZ,.;:()";
+    std::string literal = "\"";
+    for (size_t i = 0; i < length; i++) {
+        if (pick(64) == 0) {
+            literal += "\\\"";
+        } else {
+            literal.push_back(alphabet[pick(sizeof(alphabet) - 1)]);
+        }
+    }
+    return literal + "\"";
+}
+
+void Generator::expressions(std::string& out) {
+    std::string var = name("v");
+    out += "let " + var + " = " + expression(6) + ";\n";
+}
+
+void Generator::nested(std::string& out) {
+    const int depth = 16 + pick(32);
+    out += "function " + name("fn") + "(va) {\n";
+    for (int i = 0; i < depth; i++) {
+        const char* keyword = pick(2) ? "if (" : "while (";
+        out += std::string(i + 1, ' ') + keyword + expression(2) + ") {\n";
+        std::string var = name("v");
+        out += std::string(i + 2, ' ') + "let " + var + " = " + expression(2) + ";\n";
+    }
+    out += std::string(depth + 1, ' ') + "return va;\n";
+    for (int i = depth - 1; i >= 0; i--) {
+        out += std::string(i + 1, ' ') + "}\n";
+    }
+    out += "}\n";
+}
+
+void Generator::functions(std::string& out) {
+    std::string fn = name("fn");
+    out += "function " + fn + "(va, vb) {\n    return va + vb - " + expression(1) + ";\n}\n";
+    std::string var = name("v");
+    std::string first = expression(1);
+    std::string second = expression(1);
+    out += "let " + var + " = " + fn + "(" + first + ", " + second + ");\n";
+}
+
+void Generator::strings(std::string& out) {
+    std::string var = name("v");
+    out += "let " + var + " = " + string_literal(200 + pick(1800)) + ";\n";
+}
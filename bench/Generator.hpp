@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include <string>
+
+// Workload shapes for the benchmark harness.
+enum class Shape {
+    EXPRESSIONS, // long arithmetic/logical initializers
+    NESTED,      // deeply nested if/while blocks
+    FUNCTIONS,   // many small functions and calls to them
+    STRINGS,     // long string literals with escapes
+    COUNT
+};
+
+const char* shape_name(Shape shape);
+bool parse_shape(const std::string& name, Shape& shape);
+
+// Produces the same program for the same shape, seed and size on every
+// platform: only raw mt19937 output is used, never <random> distributions.
+class Generator {
+public:
+    Generator(Shape shape, uint32_t seed) : shape(shape), rng(seed), names(0) {}
+
+    // Appends top-level declarations until the program is at least `bytes` long.
+    std::string generate(size_t bytes);
+
+private:
+    Shape shape;
+    std::mt19937 rng;
+    size_t names;
+
+    size_t pick(size_t count) { return rng() % count; }
+    std::string name(const char* prefix);
+    std::string expression(int depth);
+    std::string string_literal(size_t length);
+
+    void expressions(std::string& out);
+    void nested(std::string& out);
+    void functions(std::string& out);
+    void strings(std::string& out);
+};
@@ -0,0 +1,192 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "Stats.hpp"
+
+// Memory for AST nodes (and later the runtime) comes from an Allocator
+// rather than straight from global new, so a job can pool it, release it in
+// one go, or cap it. This covers the node objects themselves; the strings
+// and vectors they hold, and the lexer's tokens, still use the global heap,
+// so budgets and per-phase counts measure node storage only. Allocators
+// stack: each takes an upstream allocator that supplies its raw memory.
+// Unless stated otherwise an allocator is not thread-safe; like an isolate,
+// use one per job.
+class Allocator {
+public:
+    virtual ~Allocator() = default;
+
+    // Throws std::bad_alloc, or MemoryBudgetExceeded from a budgeted
+    // TrackingAllocator, when it cannot satisfy the request.
+    virtual void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) = 0;
+    // `size` and `alignment` must be the ones passed to allocate().
+    virtual void deallocate(void* pointer, size_t size, size_t alignment = alignof(std::max_align_t)) noexcept = 0;
+};
+
+// Global new and delete. Thread-safe; the default for every thread.
+Allocator& default_allocator();
+
+// Raised when an allocation would take a script past its memory budget.
+class MemoryBudgetExceeded : public std::runtime_error {
+public:
+    MemoryBudgetExceeded(size_t requested, size_t live, size_t budget);
+
+    size_t requested;
+    size_t live;
+    size_t budget;
+};
+
+// Bump allocation from large blocks. deallocate() is a no-op; everything is
+// released at once by reset() or the destructor, so it suits data that dies
+// together, such as one parse's AST.
+class ArenaAllocator : public Allocator {
+public:
+    explicit ArenaAllocator(Allocator& upstream = default_allocator(), size_t blockSize = 64 * 1024);
+    ~ArenaAllocator() override;
+
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) override;
+    void deallocate(void*, size_t, size_t) noexcept override {}
+
+    // Releases every block. Nothing allocated here may be used afterwards.
+    void reset();
+    size_t used() const { return bytesUsed; }
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    Allocator& upstream;
+    size_t blockSize;
+    std::vector<Block> blocks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t bytesUsed = 0;
+};
+
+// Free lists per size class, carved from large upstream chunks, so nodes
+// that are freed and reallocated (pass rewrites, incremental re-parses) reuse
+// memory instead of going back to the heap. Requests above the largest class
+// or with unusual alignment go straight upstream. Chunks are returned only by
+// the destructor.
+class PoolAllocator : public Allocator {
+public:
+    explicit PoolAllocator(Allocator& upstream = default_allocator(), size_t chunkSize = 64 * 1024);
+    ~PoolAllocator() override;
+
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) override;
+    void deallocate(void* pointer, size_t size, size_t alignment = alignof(std::max_align_t)) noexcept override;
+
+private:
+    static constexpr size_t classSizes[] = {16, 32, 48, 64, 96, 128, 192, 256};
+    static constexpr size_t CLASS_COUNT = sizeof(classSizes) / sizeof(classSizes[0]);
+
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    static size_t size_class(size_t size);
+
+    Allocator& upstream;
+    size_t chunkSize;
+    std::vector<void*> chunks;
+    FreeSlot* freeLists[CLASS_COUNT] = {};
+    char* cursor = nullptr;
+    char* limit = nullptr;
+};
+
+// Counts what passes through it, per Phase, and enforces an optional budget
+// on live bytes. Counters are atomic, so one tracker can sit over a
+// thread-safe upstream; the phase is shared by all threads.
+class TrackingAllocator : public Allocator {
+public:
+    explicit TrackingAllocator(Allocator& upstream = default_allocator(), size_t budget = SIZE_MAX);
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) override;
+    void deallocate(void* pointer, size_t size, size_t alignment = alignof(std::max_align_t)) noexcept override;
+
+    // Attributes later allocations to `phase`; returns the previous one.
+    Phase enter(Phase phase);
+
+    // Enters a phase for the enclosing scope.
+    class PhaseScope {
+    public:
+        PhaseScope(TrackingAllocator& tracker, Phase phase) : tracker(tracker), previous(tracker.enter(phase)) {}
+        ~PhaseScope() { tracker.enter(previous); }
+
+    private:
+        TrackingAllocator& tracker;
+        Phase previous;
+    };
+
+    size_t allocations(Phase phase) const { return phaseAllocations[(size_t)phase].load(std::memory_order_relaxed); }
+    size_t bytes(Phase phase) const { return phaseBytes[(size_t)phase].load(std::memory_order_relaxed); }
+    size_t live() const { return liveBytes.load(std::memory_order_relaxed); }
+    size_t peak() const { return peakBytes.load(std::memory_order_relaxed); }
+    size_t budget() const { return limit; }
+
+    // Allocation count and bytes for every phase that allocated, then live
+    // and peak bytes.
+    void report(std::ostream& out) const;
+
+private:
+    Allocator& upstream;
+    size_t limit;
+    std::atomic<Phase> current{Phase::READ};
+    std::atomic<size_t> phaseAllocations[(size_t)Phase::COUNT] = {};
+    std::atomic<size_t> phaseBytes[(size_t)Phase::COUNT] = {};
+    std::atomic<size_t> liveBytes{0};
+    std::atomic<size_t> peakBytes{0};
+};
+
+// Lets several threads share an allocator that is not thread-safe by locking
+// around each call. Meant as the upstream of per-thread arenas, such as the
+// worker arenas of Parser::parse_parallel, which only come back for blocks.
+class SynchronizedAllocator : public Allocator {
+public:
+    explicit SynchronizedAllocator(Allocator& upstream) : upstream(upstream) {}
+
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) override;
+    void deallocate(void* pointer, size_t size, size_t alignment = alignof(std::max_align_t)) noexcept override;
+
+private:
+    Allocator& upstream;
+    std::mutex lock;
+};
+
+// The allocator AST nodes on this thread come from; default_allocator()
+// unless an AllocatorScope is active.
+Allocator& current_allocator();
+
+// Makes `allocator` current on this thread for the enclosing scope.
+class AllocatorScope {
+public:
+    explicit AllocatorScope(Allocator& allocator);
+    ~AllocatorScope();
+
+    AllocatorScope(const AllocatorScope&) = delete;
+    AllocatorScope& operator=(const AllocatorScope&) = delete;
+
+private:
+    Allocator* previous;
+};
+
+// Base for classes whose instances come from current_allocator(). Each
+// object remembers its allocator, so it can be deleted after the scope that
+// created it has ended, as long as the allocator itself is still alive.
+class AllocatedObject {
+public:
+    static void* operator new(size_t size);
+    static void operator delete(void* pointer) noexcept;
+};
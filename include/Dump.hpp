@@ -0,0 +1,122 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Image.hpp"
+#include "Lexer.hpp"
+#include "ast/Statement.hpp"
+
+// Token and AST dumps for downstream tools. The text form is the driver's
+// default token listing. The binary forms are images in the Image.hpp style:
+// a DumpHeader, then fixed-size records, then the string pool, so a consumer
+// can map the file with DumpImage and read it in place.
+
+// Buffers output and hands it to the file descriptor one full chunk at a
+// time, with a single write(2) per chunk (repeated only on short writes).
+class OutputBuffer {
+public:
+    explicit OutputBuffer(int fd, size_t capacity = 1 << 16);
+    // Flushes; errors are lost here, so call flush() first to see them.
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer&) = delete;
+    OutputBuffer& operator=(const OutputBuffer&) = delete;
+
+    void write(const char* data, size_t size);
+    void write(std::string_view text) { write(text.data(), text.size()); }
+    void write(long long value);
+    template <typename T>
+    void write_records(const T* records, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>, "records are copied bytewise");
+        write(reinterpret_cast<const char*>(records), count * sizeof(T));
+    }
+
+    // Throws std::runtime_error if the descriptor rejects the data.
+    void flush();
+
+private:
+    int fd;
+    std::vector<char> buffer;
+    size_t used = 0;
+};
+
+struct DumpHeader {
+    char magic[8];        // "AGTOK\0\0\0" or "AGAST\0\0\0"
+    uint32_t version;
+    uint32_t recordCount;
+    uint32_t stringsSize;
+    uint32_t reserved;
+    uint64_t records;     // offsets from the start of the image
+    uint64_t strings;
+};
+
+constexpr uint32_t DUMP_VERSION = 1;
+
+// AST records are written in preorder. Every node's children follow it in a
+// fixed order, with an EMPTY record standing in for an absent child, and
+// `end` is the index just past its subtree so readers can skip it.
+enum class AstKind : uint16_t {
+    EMPTY,
+    LITERAL,          // op: literal token type; text: its value
+    VARIABLE,         // text: name
+    ASSIGN,           // text: name; value
+    UNARY,            // op; operand
+    BINARY,           // op; left, right
+    CALL,             // callee, then `count` arguments
+    EXPRESSION,       // expression
+    LET,              // text: name; initializer
+    BLOCK,            // `count` statements
+    IF,               // condition, then, else
+    WHILE,            // condition, body
+    FOR,              // initializer, condition, increment, body
+    PARALLEL_FOR,     // text: variable; target: reduction target; op: Reduction; iterable, body
+    RETURN,           // value
+    IMPORT,           // text: path
+    FUNCTION,         // text: name; `count` PARAMETERs, then body (EMPTY while lazy)
+    PARAMETER,        // text: name
+};
+
+struct AstRecord {
+    AstKind kind;
+    uint16_t op;      // TokenType, or Reduction for PARALLEL_FOR
+    uint32_t end;     // index past the last record of this subtree
+    uint32_t count;   // variable-length child lists, see AstKind
+    uint32_t flags;   // AST_MEMO, AST_LAZY on FUNCTION
+    StringRef text;
+    StringRef target;
+};
+
+constexpr uint32_t AST_MEMO = 1;
+constexpr uint32_t AST_LAZY = 2;
+
+static_assert(std::is_trivially_copyable_v<DumpHeader> && sizeof(DumpHeader) == 40, "DumpHeader is an on-disk layout");
+static_assert(std::is_trivially_copyable_v<AstRecord> && sizeof(AstRecord) == 32, "AstRecord is an on-disk layout");
+
+// One "Token: NAME, Value: '...', Line: L, Col: C" line per token.
+void dump_tokens_text(const std::vector<Token>& tokens, OutputBuffer& out);
+// DumpHeader "AGTOK" + TokenRecord per token + string pool.
+void dump_tokens_binary(const std::vector<Token>& tokens, OutputBuffer& out);
+// DumpHeader "AGAST" + AstRecord per node + string pool; nullptr entries
+// (empty statements) become EMPTY records.
+void dump_ast_binary(const std::vector<StmtPtr>& program, OutputBuffer& out);
+
+// A mapped binary dump. Throws std::runtime_error if the file is not a dump
+// of the expected kind and version, or its tables are out of range.
+class DumpImage {
+public:
+    enum class Kind { TOKENS, AST };
+
+    DumpImage(const std::string& path, Kind kind);
+
+    size_t size() const { return head->recordCount; }
+    const TokenRecord* tokens() const { return static_cast<const TokenRecord*>(records); }
+    const AstRecord* nodes() const { return static_cast<const AstRecord*>(records); }
+    std::string_view strings() const { return pool; }
+
+private:
+    MappedFile file;
+    const DumpHeader* head = nullptr;
+    const void* records = nullptr;
+    std::string_view pool;
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "WorkerPool.hpp"
+
+// Single-threaded epoll loop behind the async builtins (read_file,
+// write_file, sleep, socket reads). An operation registers its completion
+// and returns at once; the completion runs later on the loop thread. The
+// runtime passes a completion that resumes the suspended AGScript frame, so
+// one thread can keep thousands of script calls in flight.
+//
+// Sockets and pipes are watched with epoll directly. Regular files cannot be
+// polled, so their I/O runs on the optional WorkerPool (or inline when there
+// is none) and the completion is posted back to the loop.
+//
+// Destroying the loop waits for file operations already running on the pool
+// and skips those still queued; like every other operation left in flight,
+// their completions are dropped without running. It never waits for a queued
+// job, so a job may destroy a loop that offloads to its own pool, even a
+// one-thread one.
+class EventLoop {
+public:
+    struct Result {
+        int error = 0;    // errno value, 0 on success
+        std::string data; // bytes read; empty at end of stream
+    };
+    using Completion = std::function<void(Result)>;
+
+    explicit EventLoop(WorkerPool* blocking = nullptr);
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void read_file(std::string path, Completion done);
+    void write_file(std::string path, std::string data, Completion done);
+    void sleep(long milliseconds, Completion done);
+    // Completes with the first chunk of at most `max` bytes, or empty at EOF.
+    // The descriptor is switched to non-blocking mode; one read per fd at a time.
+    void read(int fd, size_t max, Completion done);
+
+    // Runs `task` on the loop thread. Safe to call from any thread.
+    void post(std::function<void()> task);
+
+    // Dispatches completions until no operation is left in flight.
+    void run();
+    size_t in_flight() const { return pending; }
+
+private:
+    struct Reader {
+        size_t max;
+        Completion done;
+    };
+
+    struct Timer {
+        uint64_t deadline; // CLOCK_MONOTONIC, nanoseconds
+        uint64_t sequence; // keeps equal deadlines in submission order
+        Completion done;
+
+        bool operator>(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence;
+        }
+    };
+
+    int epoll;
+    int wakeFd;
+    int timerFd;
+    WorkerPool* blocking;
+    size_t pending = 0;
+
+    std::unordered_map<int, Reader> readers;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    uint64_t timerSequence = 0;
+
+    // Shared with the pool jobs, so a job that starts after the loop is gone
+    // can still see that it was closed.
+    struct Offloads {
+        std::mutex lock;
+        std::condition_variable idle;
+        size_t running = 0; // jobs that may still post
+        bool closing = false;
+    };
+
+    std::mutex postLock;
+    std::vector<std::function<void()>> posted;
+    std::shared_ptr<Offloads> offloads = std::make_shared<Offloads>();
+
+    void complete(Completion& done, Result result);
+    void offload(std::function<Result()> work, Completion done);
+    void arm_timer();
+    void fire_timers();
+    void drain_posted();
+    void on_readable(int fd);
+};
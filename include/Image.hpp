@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include "Lexer.hpp"
+
+// Building blocks for the binary image formats (snapshots, token dumps).
+// Records are fixed-size PODs in native byte order. They refer to each other
+// only by index or by offset from the start of the image, never by pointer,
+// so a file can be mapped at any address and read in place.
+
+struct StringRef {
+    uint32_t offset; // into the image's string pool
+    uint32_t length;
+};
+
+struct TokenRecord {
+    uint64_t offset;   // Token::offset
+    StringRef value;
+    int32_t line;
+    int32_t column;
+    uint16_t type;     // TokenType
+    uint16_t reserved[3];
+};
+
+static_assert(std::is_trivially_copyable_v<TokenRecord> && sizeof(TokenRecord) == 32, "TokenRecord is an on-disk layout");
+
+// Append-only string storage with deduplication; identifiers and keywords
+// repeat a lot, so each distinct spelling is stored once.
+class StringPool {
+public:
+    StringRef add(std::string_view text);
+    const std::string& data() const { return bytes; }
+
+private:
+    std::string bytes;
+    std::unordered_map<std::string, StringRef> refs;
+};
+
+TokenRecord to_record(const Token& token, StringPool& strings);
+// `strings` is the whole pool the record's value refers into. Throws
+// std::runtime_error if the record is out of range.
+Token from_record(const TokenRecord& record, std::string_view strings);
+
+// Pads `image` to `T`'s alignment, appends the records and returns the
+// offset of the first one.
+template <typename T>
+uint64_t append_records(std::string& image, const T* records, size_t count) {
+    static_assert(std::is_trivially_copyable_v<T>, "records are copied bytewise");
+    image.resize((image.size() + alignof(T) - 1) / alignof(T) * alignof(T), '\0');
+    uint64_t offset = image.size();
+    image.append(reinterpret_cast<const char*>(records), count * sizeof(T));
+    return offset;
+}
+
+// Read-only private mapping of a whole file. Throws std::runtime_error if the
+// file cannot be opened or mapped.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return static_cast<const char*>(address); }
+    size_t size() const { return length; }
+
+    // `count` records of type T at `offset`, or nullptr if they would not lie
+    // within the file or are misaligned.
+    template <typename T>
+    const T* records(uint64_t offset, uint64_t count) const {
+        if (offset % alignof(T) != 0 || offset > length || count > (length - offset) / sizeof(T)) return nullptr;
+        return reinterpret_cast<const T*>(data() + offset);
+    }
+
+private:
+    void* address = nullptr;
+    size_t length = 0;
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "Lexer.hpp"
+#include "Parser.hpp"
+
+// Replace `removed` bytes at `offset` (in the pre-edit source) with `inserted`.
+struct TextEdit {
+    size_t offset;
+    size_t removed;
+    std::string inserted;
+};
+
+// Tokens [begin, oldEnd) of the previous stream became [begin, newEnd).
+struct RelexResult {
+    size_t begin;
+    size_t oldEnd;
+    size_t newEnd;
+};
+
+// Re-lexes `tokens` in place for a `source` that already has `edit` applied.
+// Lexing restarts two tokens before the edit, far enough back for any token
+// the edit can extend, and stops at the first new token that matches an old
+// one in type, value and offset; the tail is then shifted, not lexed, which
+// still visits every later token (IncrementalDocument does not). Throws
+// std::out_of_range if the edit does not fit the source.
+RelexResult relex(const std::string& source, std::vector<Token>& tokens, const TextEdit& edit);
+
+// Source, tokens and AST kept in sync across edits, stored per top-level
+// declaration (see Parser::split_top_level). Each segment owns its slice of
+// the text, its tokens and its statements, all positioned relative to its
+// own start, so an edit re-lexes and re-parses only the segments it touches
+// and leaves the others, text and subtrees included, exactly as they were.
+// Where a segment starts is the sum of the lengths before it, cached up to
+// the first segment an edit changed and extended on demand.
+class IncrementalDocument {
+public:
+    struct Position {
+        size_t offset;
+        int line;
+        int column;
+    };
+
+    struct Segment {
+        // From the segment's first token (the start of the text, for the
+        // first segment) up to the next segment's first token.
+        std::string text;
+        // `text` lexed as if it started at line 1, column 1, closed by an
+        // END_OF_FILE token at its end. Lazy bodies index into these, and the
+        // lines in `statements` count from the segment's first line too.
+        std::vector<Token> tokens;
+        std::vector<StmtPtr> statements;
+        int lines = 0;       // newlines in `text`
+        int endColumn = 1;   // column just past `text`, relative like the tokens'
+    };
+
+    // Throws std::runtime_error if the text is not valid UTF-8.
+    explicit IncrementalDocument(std::string source, bool lazyFunctions = false);
+
+    // Throws std::out_of_range if the edit does not fit the text and
+    // std::runtime_error if the result would not be valid UTF-8; a rejected
+    // edit leaves the document unchanged.
+    void apply(const TextEdit& edit);
+    void parse_function_body(size_t segment, FunctionDeclaration& function);
+
+    size_t segment_count() const { return parts.size(); }
+    const Segment& segment(size_t index) const { return *parts[index]; }
+    size_t size() const { return length; }
+    // Where segment `index` starts in the whole text.
+    Position start(size_t index) const;
+    // A token of segment `index` as a fresh lex of the whole text has it.
+    Token absolute(size_t index, const Token& token) const;
+
+    // The whole text and token stream, assembled on each call.
+    std::string source() const;
+    std::vector<Token> tokens() const;
+
+private:
+    // Held by pointer so that splitting or joining segments only moves
+    // pointers along the list.
+    std::vector<std::unique_ptr<Segment>> parts;
+    size_t length = 0;
+    bool lazyFunctions;
+
+    // origins[i] is valid for i < known.
+    mutable std::vector<Position> origins;
+    mutable size_t known = 0;
+
+    size_t locate(size_t offset) const;
+    char byte_at(size_t offset) const;
+    std::vector<std::unique_ptr<Segment>> make_segments(const std::string& region, std::vector<Token> tokens, bool whole) const;
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Allocator.hpp"
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "Snapshot.hpp"
+
+// Interned strings for one isolate. References stay valid for the table's
+// lifetime, so identifiers can be compared and hashed by address.
+class StringTable {
+public:
+    const std::string& intern(std::string_view text);
+    const std::string* find(std::string_view text) const;
+    size_t size() const { return strings.size(); }
+
+private:
+    std::unordered_set<std::string> strings;
+};
+
+// One independent interpreter instance. Everything a script can reach -
+// sources, tokens, AST, globals, interned names - is owned here, so isolates
+// on different threads share no mutable state. An isolate itself is not
+// thread-safe; use one per job.
+//
+// AST nodes come from the isolate's own pool, counted per phase by
+// memory(). With a budget, a load whose node storage would take the isolate
+// past it throws MemoryBudgetExceeded and leaves the isolate as it was; the
+// strings and lists inside nodes are not counted.
+class Isolate {
+public:
+    explicit Isolate(size_t memoryBudget = SIZE_MAX) : tracker(pool, memoryBudget) {}
+    Isolate(const Isolate&) = delete;
+    Isolate& operator=(const Isolate&) = delete;
+
+    // Lexes and parses `source`, then binds its top-level functions and
+    // variables as globals. Later loads shadow earlier globals of the same name.
+    void load(std::string source);
+
+    // Writes everything loaded so far as one snapshot image (see
+    // Snapshot.hpp), so a later isolate can start from the same globals with
+    // load_snapshot() instead of lexing and parsing the prelude again.
+    void save_snapshot(const std::string& path) const;
+    // Maps a snapshot image and binds its globals as load() would. Its
+    // functions come back with lazy bodies; parse them through
+    // parse_function_body() before use.
+    void load_snapshot(const std::string& path);
+    void parse_function_body(FunctionDeclaration& function);
+
+    const Statement* global(std::string_view name) const;
+    StringTable& strings() { return names; }
+    const TrackingAllocator& memory() const { return tracker; }
+
+private:
+    struct Unit {
+        std::string source;
+        std::vector<Token> tokens;
+        std::vector<StmtPtr> program;
+        // Set for snapshot units, whose function bodies' tokens are only
+        // decoded from the image when the body is parsed.
+        std::unique_ptr<Snapshot> image;
+    };
+
+    void bind(const Unit& unit);
+
+    // Declared before the units so they outlive every node.
+    PoolAllocator pool;
+    TrackingAllocator tracker;
+    std::vector<std::unique_ptr<Unit>> units;
+    StringTable names;
+    std::unordered_map<const std::string*, const Statement*> globals;
+};
@@ -1,12 +1,17 @@
 #ifndef TokenHeader
 #define TokenHeader
-#endif
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <iterator>
 #include <cctype>
+#include <cstring>
+#include <stdexcept>
 #include <vector>
 #include <unordered_map>
+#include "Utf8.hpp"
+#include "Xid.hpp"
 
 enum class TokenType {
     IDENTIFIER,
@@ -37,6 +42,7 @@ enum class TokenType {
     END_OF_FILE,
     COMMA,
     SEMI_COLON,
+    COLON,
     INT_LITERAL,
     STRING_LITERAL,
     BOOLEAN_LITERAL,
@@ -50,22 +56,56 @@ enum class TokenType {
     IN,
     FOR, 
     LET,
+    IMPORT,
+    PARALLEL,
+    REDUCE,
+    MEMO,
     UNKNOWN
 };
 
+// Display names, indexed by TokenType; the spelling the token dump uses.
+inline constexpr std::string_view tokenNames[] = {
+    "IDENTIFIER", "IF", "PLUS", "MULTIPLY", "MINUS", "DIVIDE", "EQUAL", "FUNCTION",
+    "LEFT_PAREN", "RIGHT_PAREN", "NOT_EQUAL", "LESS_THAN", "LESS_EQUAL", "GREATER_THAN",
+    "GREATER_EQUAL", "AND", "OR", "NOT", "LEFT_BRACKET", "RIGHT_BRACKET", "LEFT_BRACE",
+    "RIGHT_BRACE", "DOT", "NEW_LINE", "COMMENT", "END_OF_FILE", "COMMA", "SEMI_COLON", "COLON",
+    "INT_LITERAL", "STRING_LITERAL", "BOOLEAN_LITERAL", "FLOAT_LITERAL", "NULL_LITERAL", "ASSIGN",
+    "KEYWORD", "ELSE", "RETURN", "WHILE", "IN", "FOR", "LET", "IMPORT", "PARALLEL", "REDUCE",
+    "MEMO", "UNKNOWN",
+};
+
+static_assert(std::size(tokenNames) == (size_t)TokenType::UNKNOWN + 1, "one name per TokenType");
+
+constexpr std::string_view token_name(TokenType type) {
+    return tokenNames[(size_t)type];
+}
+
 struct Token {
     TokenType type;
     std::string value;
     int line;
     int column;
+    size_t offset = 0; // byte offset of the first character in the source
 };
 
 class Lexer {
     public:
-        Lexer(const std::string& source): source(source), position(0), line(1), column(1) {}
+        // Throws std::runtime_error unless `source` is valid UTF-8.
+        Lexer(const std::string& source): source(source), position(0), line(1), column(1) {
+            size_t invalid = utf8_invalid_offset(source.data(), source.size());
+            if (invalid != source.size()) {
+                advanceTo(invalid);
+                throw std::runtime_error("Invalid UTF-8 at line " + std::to_string(line) + ", column " + std::to_string(column));
+            }
+        }
+        // Resumes lexing at a known token start, e.g. when re-lexing an edit.
+        // The source is not validated again; the caller checks what changed.
+        Lexer(const std::string& source, size_t position, int line, int column)
+            : source(source), position(position), line(line), column(column) {}
         
         Token getNextToken() {
         skipWhitespace();
+        tokenStart = position;
         
         if (position >= source.size()) {
             return makeToken(TokenType::END_OF_FILE, "");
@@ -77,16 +117,34 @@ class Lexer {
             return lexBoolean();
         }
 
-        // Identifiers: [a-zA-Z_][a-zA-Z0-9_]*
-        if (std::isalpha(current) || current == '_') {
+        // Identifiers: ASCII letters, '_' and XID_Start code points
+        if (identifierCharAt(position, true)) {
             return lexBoolean();
         };
 
+        // Any other non-ASCII code point is one UNKNOWN token, not a run of
+        // stray bytes.
+        if ((unsigned char)current >= 0x80) {
+            size_t length;
+            utf8_decode(source.data() + position, length);
+            int startColumn = column;
+            advanceTo(position + length);
+            return Token{TokenType::UNKNOWN, source.substr(tokenStart, length), line, startColumn, tokenStart};
+        };
+
         // Integer literals: [0-9]+
-        if (std::isdigit(current)) {
+        if (std::isdigit((unsigned char)current)) {
             return lexNumber();
         };
 
+        // skipWhitespace() only stops at "/*" when the comment never ends.
+        if (current == '/' && position + 1 < source.size() && source[position + 1] == '*') {
+            int startLine = line;
+            int startColumn = column;
+            advanceTo(source.size());
+            return Token{TokenType::UNKNOWN, "/*", startLine, startColumn, tokenStart};
+        };
+
         if (current == '\"') {
             return lexString();
         };
@@ -111,18 +169,21 @@ class Lexer {
             case ';':
                 advance();
                 return makeToken(TokenType::SEMI_COLON, ";");
+            case ':':
+                advance();
+                return makeToken(TokenType::COLON, ":");
             case '{':
                 advance();
-                return makeToken(TokenType::LEFT_BRACKET, "{");
+                return makeToken(TokenType::LEFT_BRACE, "{");
             case '}':
                 advance();
-                return makeToken(TokenType::RIGHT_BRACKET, "}");
+                return makeToken(TokenType::RIGHT_BRACE, "}");
             case '[':
                 advance();
-                return makeToken(TokenType::LEFT_BRACE, "]");
+                return makeToken(TokenType::LEFT_BRACKET, "[");
             case ']':
                 advance();
-                return makeToken(TokenType::RIGHT_BRACE, "]");
+                return makeToken(TokenType::RIGHT_BRACKET, "]");
             case '.':
                 advance();
                 return makeToken(TokenType::DOT, ".");
@@ -144,40 +205,109 @@ class Lexer {
     private:
         const std::string& source;
         size_t position;
+        size_t tokenStart = 0;
         int line;
         int column;
 
+        // Columns count code points, so continuation bytes do not move them.
         void advance() {
             if (source[position] == '\n') {
                 line++;
                 column = 1;
-            } else {
+            } else if (!utf8_continuation(source[position])) {
                 column++;
             }
             position++;
         };
 
+        // Jumps forward to `target`, finding newlines with memchr instead of
+        // stepping through every byte.
+        void advanceTo(size_t target) {
+            const char* from = source.data() + position;
+            const char* end = source.data() + target;
+            while (const char* newline = static_cast<const char*>(std::memchr(from, '\n', end - from))) {
+                line++;
+                column = 1;
+                from = newline + 1;
+            }
+            for (; from < end; from++) {
+                if (!utf8_continuation(*from)) column++;
+            }
+            position = target;
+        };
+
+        // Size in bytes of the identifier character at `at`, or 0 if there is
+        // none. ASCII allows letters and '_' only; other code points need
+        // XID_Start to begin an identifier and XID_Continue to extend one.
+        size_t identifierCharAt(size_t at, bool start) const {
+            unsigned char byte = source[at];
+            if (byte < 0x80) return std::isalpha(byte) || byte == '_' ? 1 : 0;
+
+            size_t length;
+            char32_t code = utf8_decode(source.data() + at, length);
+            return (start ? xid_start(code) : xid_continue(code)) ? length : 0;
+        };
+
+        // Whitespace, "// ..." to the end of the line and "/* ... */".
         void skipWhitespace() {
-            while (position < source.size() && std::isspace(source[position])) {
-                advance();
+            while (position < source.size()) {
+                char current = source[position];
+                if (std::isspace((unsigned char)current)) {
+                    advance();
+                } else if (current == '/' && position + 1 < source.size() && source[position + 1] == '/') {
+                    skipLineComment();
+                } else if (current == '/' && position + 1 < source.size() && source[position + 1] == '*') {
+                    if (!skipBlockComment()) return;
+                } else {
+                    return;
+                }
             };
         };
 
+        // Stops on the newline, which the whitespace loop then consumes and
+        // which resets the column, so only the position has to move.
+        void skipLineComment() {
+            const void* newline = std::memchr(source.data() + position, '\n', source.size() - position);
+            if (newline) {
+                position = static_cast<const char*>(newline) - source.data();
+            } else {
+                advanceTo(source.size());
+            }
+        };
+
+        // False, without moving, if the comment is never closed.
+        bool skipBlockComment() {
+            size_t search = position + 2;
+            while (search < source.size()) {
+                const void* star = std::memchr(source.data() + search, '*', source.size() - search);
+                if (!star) break;
+
+                size_t at = static_cast<const char*>(star) - source.data();
+                if (at + 1 < source.size() && source[at + 1] == '/') {
+                    advanceTo(at + 2);
+                    return true;
+                }
+                search = at + 1;
+            }
+            return false;
+        };
+
         Token makeToken(TokenType type, const std::string& value) {
-            return Token{type, value, line, column - (int)value.size()};
+            return Token{type, value, line, column - (int)value.size(), tokenStart};
         };
 
         Token lexIdentifier() {
             size_t start = position;
             int startCol = column;
-            while (position < source.size() && (std::isalnum(source[position]) || source[position] == '_')) {
+            while (position < source.size() && (std::isalnum((unsigned char)source[position]) || source[position] == '_')) {
                 advance();
             }
-            return Token{TokenType::IDENTIFIER, source.substr(start, position - start), line, startCol};
+            return Token{TokenType::IDENTIFIER, source.substr(start, position - start), line, startCol, tokenStart};
         }
 
         Token lexString() {
             size_t start = position;      // Position of the opening quote
+            int startLine = line;
             int startColumn = column;
             
             advance();  // skip the opening quote '"'
@@ -210,7 +340,7 @@ class Lexer {
                 };
             };
 
-            return Token{TokenType::STRING_LITERAL, strContent, line, startColumn};
+            return Token{TokenType::STRING_LITERAL, strContent, startLine, startColumn, tokenStart};
         };
 
         Token lexBoolean() {
@@ -219,12 +349,13 @@ class Lexer {
 
             std::string ident;
 
-            while (position < source.size() && std::isalpha(source[position])) {
-                ident.push_back(source[position]);
-                advance();
+            size_t length;
+            while (position < source.size() && (length = identifierCharAt(position, position == start)) != 0) {
+                ident.append(source, position, length);
+                for (size_t i = 0; i < length; i++) advance();
             }
 
-            static std::unordered_map<std::string, TokenType> keywords = {
+            static const std::unordered_map<std::string, TokenType> keywords = {
                 {"return", TokenType::RETURN},
                 {"function", TokenType::FUNCTION},
                 {"if", TokenType::IF},
@@ -239,6 +370,10 @@ class Lexer {
                 {"for", TokenType::FOR},
                 {"in", TokenType::IN},
                 {"let", TokenType::LET},
+                {"import", TokenType::IMPORT},
+                {"parallel", TokenType::PARALLEL},
+                {"reduce", TokenType::REDUCE},
+                {"memo", TokenType::MEMO},
             };
 
             auto it = keywords.find(ident);
@@ -246,21 +381,30 @@ class Lexer {
             // std::cout << "lexed identifier: " << ident << "\n";
 
             if (it != keywords.end()) {
-                return Token{it->second, ident, line, startColumn};
+                return Token{it->second, ident, line, startColumn, tokenStart};
             }
 
             // Not a keyword: it's just a name (could be a variable)
-            return Token{TokenType::IDENTIFIER, ident, line, startColumn};
+            return Token{TokenType::IDENTIFIER, ident, line, startColumn, tokenStart};
 
         }
 
         Token lexNumber() {
             size_t start = position;
             int startCol = column;
-            while (position < source.size() && std::isdigit(source[position])) {
+            while (position < source.size() && std::isdigit((unsigned char)source[position])) {
+                advance();
+            }
+
+            // A '.' only starts a fraction when a digit follows it.
+            if (position + 1 < source.size() && source[position] == '.' && std::isdigit((unsigned char)source[position + 1])) {
                 advance();
+                while (position < source.size() && std::isdigit((unsigned char)source[position])) {
+                    advance();
+                }
+                return Token{TokenType::FLOAT_LITERAL, source.substr(start, position - start), line, startCol, tokenStart};
             }
-            return Token{TokenType::INT_LITERAL, source.substr(start, position - start), line, startCol};
+            return Token{TokenType::INT_LITERAL, source.substr(start, position - start), line, startCol, tokenStart};
         }
 
         Token lexAssignOrEqual() {
@@ -268,9 +412,11 @@ class Lexer {
             advance(); // consume '='
             if (position < source.size() && source[position] == '=') {
                 advance();
-                return Token{TokenType::EQUAL, "==", line, startCol};
+                return Token{TokenType::EQUAL, "==", line, startCol, tokenStart};
             } else {
-                return Token{TokenType::ASSIGN, "=", line, startCol};
+                return Token{TokenType::ASSIGN, "=", line, startCol, tokenStart};
             }
         }
-};
\ No newline at end of file
+};
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Stats.hpp"
+
+// Bounded result cache for one memoized function: calls to a `memo function`
+// that Purity marked pure are looked up by their argument values first. When
+// full, the least recently used entry is evicted. Hits and misses are counted
+// per cache and, under AGSCRIPT_STATS, in the memo_hits/memo_misses counters.
+//
+// Not thread-safe. Like everything else reachable from a script, caches
+// belong to one isolate, one per function.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class MemoCache {
+public:
+    explicit MemoCache(size_t capacity = 256) : capacity(capacity) {}
+
+    // The cached result for `key`, now most recently used; nullptr on a miss.
+    // The pointer is valid until the next insert.
+    const Value* find(const Key& key) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            missCount++;
+            STATS_ADD(Counter::MEMO_MISSES, 1);
+            return nullptr;
+        }
+        hitCount++;
+        STATS_ADD(Counter::MEMO_HITS, 1);
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+
+    // Stores the result of a miss, evicting the least recently used entry if
+    // the cache is full.
+    void insert(const Key& key, Value value) {
+        if (capacity == 0) return;
+
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = std::move(value);
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        if (entries.size() == capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, std::move(value));
+        index.emplace(key, entries.begin());
+    }
+
+    void clear() {
+        entries.clear();
+        index.clear();
+    }
+
+    size_t size() const { return entries.size(); }
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+
+private:
+    using Entry = std::pair<Key, Value>;
+
+    size_t capacity;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+    size_t hitCount = 0;
+    size_t missCount = 0;
+};
+
+// Hash for a call's argument list, so a cache can be keyed by
+// std::vector<Argument> directly.
+template <typename Argument, typename Hash = std::hash<Argument>>
+struct ArgumentsHash {
+    size_t operator()(const std::vector<Argument>& arguments) const {
+        size_t seed = arguments.size();
+        for (const auto& argument : arguments) {
+            seed ^= Hash{}(argument) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Lexer.hpp"
+#include "Parser.hpp"
+
+struct Module {
+    std::string path;                 // canonical path, also the cache key
+    std::string source;
+    std::vector<Token> tokens;
+    std::vector<StmtPtr> program;
+    std::vector<std::string> imports; // canonical paths of imported modules
+    size_t hash = 0;                  // of source
+    long long modified = 0;           // file mtime when last read
+    std::string error;                // why lexing or parsing failed; empty on success
+};
+
+// Loads a module and everything it imports. Compiled modules are cached per
+// file and a module is only recompiled when its own source changed: parsing
+// never looks at imports, so an edited import leaves its importers alone.
+// Keep one loader alive to reuse the cache.
+class ModuleLoader {
+public:
+    explicit ModuleLoader(unsigned threads = 0);
+
+    // Returns the module graph rooted at `path`, imports before importers.
+    // Throws std::runtime_error for unreadable files and import cycles. A
+    // module that fails to lex or parse is returned with `error` set and no
+    // program; the rest of the graph still loads.
+    // A recompiled module replaces its cache entry instead of being parsed in
+    // place, so handles from earlier calls keep the version they saw.
+    std::vector<std::shared_ptr<const Module>> load(const std::string& path);
+
+private:
+    struct Pending {
+        std::shared_ptr<Module> module;
+        bool changed;
+    };
+
+    std::unordered_map<std::string, std::shared_ptr<Module>> cache;
+    unsigned threads;
+
+    void discover(const std::string& path, std::unordered_map<std::string, Pending>& graph,
+                  std::vector<std::string>& stack, std::vector<std::string>& order);
+    void compile(std::vector<Module*>& modules);
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "WorkerPool.hpp"
+
+// Runtime side of `parallel for`. The iteration space [0, count) - the range
+// itself, or indices into the list - is cut into chunks that workers claim
+// from a shared counter, so fast workers simply take more chunks. Chunks are
+// submitted as pool jobs, so idle workers also steal them from busy ones.
+//
+// The calling thread claims chunks as well and only waits for chunks already
+// running, never for queued helpers. A `parallel for` inside a pool job
+// therefore cannot deadlock on its own pool.
+
+// About eight chunks per worker: enough to balance uneven iterations without
+// paying the claim and wake-up cost per element.
+inline size_t parallel_grain(size_t count, unsigned workers) {
+    return std::max<size_t>(1, count / ((size_t)std::max(1u, workers) * 8));
+}
+
+inline size_t parallel_chunk_count(size_t count, unsigned workers) {
+    size_t grain = parallel_grain(count, workers);
+    return (count + grain - 1) / grain;
+}
+
+// Calls chunk(index, begin, end) once per chunk. Rethrows the first exception
+// a chunk raised; chunks not yet started when it happened are skipped.
+template <typename Chunk>
+void parallel_chunks(WorkerPool& pool, size_t count, Chunk chunk) {
+    if (count == 0) return;
+    size_t grain = parallel_grain(count, pool.size());
+    size_t chunks = parallel_chunk_count(count, pool.size());
+
+    struct Shared {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> done{0};
+        std::atomic<bool> failed{false};
+        std::mutex lock;
+        std::condition_variable finished;
+        std::exception_ptr failure;
+    };
+    auto shared = std::make_shared<Shared>();
+
+    // Helpers may start after the loop returned; by then `next` is past the
+    // last chunk, so they never touch `chunk`, only the shared state they own.
+    auto drain = [shared, &chunk, count, grain, chunks]() {
+        size_t index;
+        while ((index = shared->next++) < chunks) {
+            if (!shared->failed) {
+                try {
+                    chunk(index, index * grain, std::min(count, (index + 1) * grain));
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(shared->lock);
+                    if (!shared->failure) shared->failure = std::current_exception();
+                    shared->failed = true;
+                }
+            }
+            if (++shared->done == chunks) {
+                std::lock_guard<std::mutex> guard(shared->lock);
+                shared->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min<size_t>(pool.size(), chunks - 1);
+    for (size_t i = 0; i < helpers; i++) pool.submit(drain);
+    drain();
+
+    std::unique_lock<std::mutex> guard(shared->lock);
+    shared->finished.wait(guard, [&]() { return shared->done == chunks; });
+    if (shared->failure) std::rethrow_exception(shared->failure);
+}
+
+// body(begin, end) runs each index in [begin, end).
+template <typename Body>
+void parallel_for(WorkerPool& pool, size_t count, Body body) {
+    parallel_chunks(pool, count, [&](size_t, size_t begin, size_t end) { body(begin, end); });
+}
+
+// body(begin, end) returns the partial result of one chunk, starting from
+// `identity`. Partials are combined left to right in chunk order, so an
+// order-sensitive combine (list append) sees results in source order no
+// matter which worker finished first.
+template <typename T, typename Body, typename Combine>
+T parallel_reduce(WorkerPool& pool, size_t count, T identity, Body body, Combine combine) {
+    std::vector<T> partials(parallel_chunk_count(count, pool.size()), identity);
+    parallel_chunks(pool, count, [&](size_t index, size_t begin, size_t end) { partials[index] = body(begin, end); });
+
+    T result = std::move(identity);
+    for (T& partial : partials) result = combine(std::move(result), std::move(partial));
+    return result;
+}
@@ -2,29 +2,47 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <utility>
+#include <cstdint>
 #include "Lexer.hpp"  // Assumes you have a Token struct/class with TokenType, lexeme, etc.
+#include "ast/Expression.hpp"
+#include "ast/Statement.hpp"
 
-class Expression;
-class Statement;
+class WorkerPool;
 
-// Base classes
-class Expression {
-public:
-    virtual ~Expression() = default;
-};
-
-class Statement {
-public:
-    virtual ~Statement() = default;
+// Statements from Parser::parse_parallel and the per-worker arenas their
+// nodes live in. The arenas take their blocks from the allocator that was
+// current for the call, which must outlive this. Members are destroyed from
+// the bottom up, so the statements go before the arenas.
+struct ParallelProgram {
+    std::unique_ptr<SynchronizedAllocator> upstream;
+    std::vector<std::unique_ptr<ArenaAllocator>> arenas;
+    std::vector<StmtPtr> statements;
 };
 
-using ExprPtr = std::unique_ptr<Expression>;
-using StmtPtr = std::unique_ptr<Statement>;
-
 class Parser {
 public:
-    Parser(const std::vector<Token>& tokens);
+    // With lazyFunctions set, function bodies are only brace-matched and their
+    // token range recorded; call parse_function_body() before first use.
+    // The token vector must then outlive the returned AST.
+    Parser(const std::vector<Token>& tokens, bool lazyFunctions = false);
+    // Parses only tokens[begin, end), e.g. one chunk from split_top_level().
+    Parser(const std::vector<Token>& tokens, size_t begin, size_t end, bool lazyFunctions = false);
+    // Syntax errors are reported and skipped; MemoryBudgetExceeded from the
+    // current allocator propagates.
     std::vector<StmtPtr> parse();
+    void parse_function_body(FunctionDeclaration& function);
+
+    // Token ranges of top-level declarations, found by bracket matching and
+    // the token before each declaration keyword only.
+    // [begin, end) must start outside any bracket pair.
+    static std::vector<std::pair<size_t, size_t>> split_top_level(const std::vector<Token>& tokens, size_t begin = 0, size_t end = SIZE_MAX);
+    // Parses the chunks from split_top_level() as jobs on `pool`, the calling
+    // thread helping, and returns the statements in source order. Each thread
+    // allocates nodes from its own arena, so workers never contend per node.
+    // An exception from any chunk, such as MemoryBudgetExceeded, is rethrown
+    // once the others have stopped.
+    static ParallelProgram parse_parallel(const std::vector<Token>& tokens, WorkerPool& pool, bool lazyFunctions = false);
 
 private:
     // Helpers
@@ -36,17 +54,21 @@ private:
     Token previous() const;
     void error(const Token& token, const std::string& message);
     void synchronize();
+    size_t skip_block();
 
     // Parsing rules (non-terminals)
     std::vector<StmtPtr> program();
     StmtPtr declaration();
     StmtPtr function_decl();
+    StmtPtr memo_function_decl();
     StmtPtr variable_decl();
+    StmtPtr import_decl();
     StmtPtr statement();
     StmtPtr expression_statement();
     StmtPtr if_statement();
     StmtPtr while_statement();
     StmtPtr for_statement();
+    StmtPtr parallel_for_statement();
     StmtPtr return_statement();
     StmtPtr block();
 
@@ -60,7 +82,7 @@ private:
     ExprPtr multiplication();
     ExprPtr unary();
     ExprPtr primary();
-    ExprPtr function_call(const ExprPtr& callee);
+    ExprPtr function_call(ExprPtr callee);
 
     std::vector<ExprPtr> parameter_list();
     std::vector<ExprPtr> argument_list();
@@ -68,4 +90,6 @@ private:
     // Tokens
     const std::vector<Token>& tokens;
     size_t current;
+    size_t end;
+    bool lazyFunctions;
 };
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <csignal>
+#include <iosfwd>
+#include <memory>
+#include "ast/Statement.hpp"
+
+// SIGPROF-driven sampling profiler for script-level call stacks.
+//
+// The runtime keeps a per-thread shadow stack of the AGScript functions it is
+// executing (Profiler::enter/leave, or ProfileScope). While a Profiler is
+// running, an ITIMER_PROF signal copies that stack into a preallocated buffer;
+// nothing in the signal path allocates, locks or touches thread_local storage.
+// Shadow stacks live in a fixed table of MaxThreads slots found by thread id,
+// and frames hold a copy of the function name (cut at MaxName - 1 bytes), so
+// a profile stays valid after the AST is freed or re-parsed. Threads beyond
+// MaxThreads are not sampled.
+class Profiler {
+public:
+    static constexpr int MaxDepth = 128;
+    static constexpr int MaxThreads = 64;
+    static constexpr size_t MaxName = 40;
+
+    struct Frame {
+        char name[MaxName];
+        int line;
+    };
+
+    // `capacity` is the number of frames kept across all samples. 99 Hz
+    // rather than 100 keeps sampling out of lockstep with periodic work.
+    explicit Profiler(int frequency = 99, size_t capacity = 1 << 16);
+    ~Profiler();
+
+    // Returns false if another profiler is already running or the timer
+    // cannot be armed.
+    bool start();
+    // Disarms the timer and returns once no signal handler is still writing
+    // into this profiler. Our handler stays installed if the previous one was
+    // SIG_DFL, so a SIGPROF still pending cannot terminate the process.
+    void stop();
+
+    // One "frame;frame;frame count" line per distinct stack, root first, as
+    // consumed by flamegraph.pl and compatible tools.
+    void write_collapsed(std::ostream& out) const;
+
+    size_t samples() const { return sampleCount.load(); }
+    size_t dropped() const { return droppedCount.load(); }
+
+    static void enter(const FunctionDeclaration& function);
+    static void leave();
+
+private:
+    struct Sample {
+        size_t begin;
+        int depth;
+    };
+
+    int frequency;
+    size_t capacity;
+    std::unique_ptr<Frame[]> frames;
+    std::unique_ptr<Sample[]> sampleBuffer;
+    size_t sampleSlots;
+    std::atomic<size_t> slotsUsed{0};
+    std::atomic<size_t> framesUsed{0};
+    std::atomic<size_t> sampleCount{0};
+    std::atomic<size_t> droppedCount{0};
+    struct sigaction previous;
+    bool running = false;
+
+    static void on_signal(int signal);
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const FunctionDeclaration& function) { Profiler::enter(function); }
+    ~ProfileScope() { Profiler::leave(); }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
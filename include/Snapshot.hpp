@@ -0,0 +1,96 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "Image.hpp"
+#include "Lexer.hpp"
+#include "ast/Statement.hpp"
+
+// Prelude snapshots. A prelude (library functions, constant tables) is lexed
+// and split into top-level declarations once, and the result is written as a
+// relocatable image: the token stream, a table of functions whose bodies stay
+// unparsed token ranges, and the ranges of the remaining top-level
+// statements. Later runs map the image and rebuild the prelude without
+// touching the source: functions come back lazy and are parsed on first call
+// with Parser::parse_function_body. Tokens are still rebuilt as Token objects
+// for the parser, so startup costs the mmap plus decoding the tokens outside
+// function bodies and reparsing the non-function statements; a body's tokens
+// are decoded when it is first parsed. At 32 bytes per token record an image
+// is roughly ten times the size of its source.
+//
+// Images are native byte order and tied to the TokenType numbering; the
+// version is bumped whenever either layout changes.
+
+struct SnapshotHeader {
+    char magic[8];          // "AGSNAP\0\0"
+    uint32_t version;
+    uint32_t tokenCount;
+    uint32_t functionCount;
+    uint32_t parameterCount;
+    uint32_t declarationCount;
+    uint32_t stringsSize;
+    uint64_t tokens;        // offsets from the start of the image
+    uint64_t functions;
+    uint64_t parameters;    // StringRef per parameter, FunctionRecords index into it
+    uint64_t declarations;
+    uint64_t strings;
+};
+
+struct FunctionRecord {
+    StringRef name;
+    uint32_t firstParameter;
+    uint32_t parameterCount;
+    uint32_t bodyBegin;     // token range, as in FunctionDeclaration
+    uint32_t bodyEnd;
+    int32_t line;
+    uint32_t flags;         // FUNCTION_MEMO
+};
+
+// One per top-level chunk, in source order.
+struct DeclarationRecord {
+    uint32_t begin;         // token range, reparsed on load unless `function` is set
+    uint32_t end;
+    int32_t function;       // index into the function table, or -1
+    uint32_t reserved;
+};
+
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr uint32_t FUNCTION_MEMO = 1;
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader> && std::is_trivially_copyable_v<FunctionRecord> &&
+              std::is_trivially_copyable_v<DeclarationRecord>, "snapshot records are on-disk layouts");
+
+// Writes the image for `tokens`, which must end with END_OF_FILE. Throws
+// std::runtime_error if the file cannot be written.
+void write_snapshot(const std::string& path, const std::vector<Token>& tokens);
+
+// A mapped, validated snapshot image. Throws std::runtime_error on open if
+// the file is not a snapshot of this version or its tables are out of range.
+class Snapshot {
+public:
+    explicit Snapshot(const std::string& path);
+
+    const SnapshotHeader& header() const { return *head; }
+    std::string_view string(StringRef ref) const;
+
+    // The whole token stream, or with `bodies` unset only the tokens outside
+    // function bodies; the rest are left default-constructed until
+    // load_token_range() fills them in.
+    std::vector<Token> load_tokens(bool bodies = true) const;
+    void load_token_range(std::vector<Token>& tokens, size_t begin, size_t end) const;
+    // Top-level statements in source order. Function bodies are left lazy,
+    // as token ranges into `tokens`, which must be load_tokens() of this
+    // image and must outlive the statements.
+    std::vector<StmtPtr> load_program(const std::vector<Token>& tokens) const;
+
+private:
+    MappedFile file;
+    const SnapshotHeader* head = nullptr;
+    const TokenRecord* tokenTable = nullptr;
+    const FunctionRecord* functionTable = nullptr;
+    const StringRef* parameterTable = nullptr;
+    const DeclarationRecord* declarationTable = nullptr;
+    std::string_view strings;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <iosfwd>
+
+// Pipeline instrumentation behind --stats. Only compiled in when the build
+// defines AGSCRIPT_STATS; otherwise every STATS_* macro expands to nothing
+// and its arguments are never evaluated.
+
+enum class Phase {
+    READ,
+    LEX,
+    PARSE,
+    PASSES,
+    COUNT
+};
+
+constexpr const char* phase_name(Phase phase) {
+    constexpr const char* names[] = {"read", "lex", "parse", "passes"};
+    return names[(size_t)phase];
+}
+
+enum class Counter {
+    BYTES,
+    TOKENS,
+    INLINED_CALLS,
+    COMMON_SUBEXPRESSIONS,
+    HOISTED_EXPRESSIONS,
+    DEAD_STATEMENTS,
+    MEMO_HITS,
+    MEMO_MISSES,
+    COUNT
+};
+
+// Counted where the parser (or a snapshot load) builds a node, so copies made
+// by the passes are not.
+enum class NodeKind {
+    LITERAL,
+    VARIABLE,
+    ASSIGN,
+    UNARY,
+    BINARY,
+    CALL,
+    EXPRESSION_STATEMENT,
+    VARIABLE_DECLARATION,
+    BLOCK,
+    IF,
+    WHILE,
+    FOR,
+    PARALLEL_FOR,
+    RETURN,
+    IMPORT,
+    FUNCTION,
+    COUNT
+};
+
+#ifdef AGSCRIPT_STATS
+#include <chrono>
+
+class Stats {
+public:
+    static void add(Counter counter, size_t amount);
+    static void node(NodeKind kind);
+    static void record(Phase phase, std::chrono::steady_clock::duration elapsed);
+    static void report(std::ostream& out, bool json);
+
+    // Running totals, for harnesses that diff them around a workload.
+    static size_t nodes(NodeKind kind);
+    static size_t allocations();
+};
+
+// Times the enclosing scope on the monotonic clock.
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase phase) : phase(phase), start(std::chrono::steady_clock::now()) {}
+    ~PhaseTimer() { Stats::record(phase, std::chrono::steady_clock::now() - start); }
+
+private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define STATS_CONCAT_(a, b) a##b
+#define STATS_CONCAT(a, b) STATS_CONCAT_(a, b)
+#define STATS_PHASE(phase) PhaseTimer STATS_CONCAT(phaseTimer, __LINE__)(phase)
+#define STATS_ADD(counter, amount) Stats::add(counter, amount)
+#define STATS_NODE(kind) Stats::node(NodeKind::kind)
+#else
+#define STATS_PHASE(phase) ((void)0)
+#define STATS_ADD(counter, amount) ((void)0)
+#define STATS_NODE(kind) ((void)0)
+#endif
@@ -0,0 +1,92 @@
+#ifndef Utf8Header
+#define Utf8Header
+
+#include <cstddef>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Continuation bytes (10xxxxxx) never start a code point.
+inline bool utf8_continuation(unsigned char byte) {
+    return (byte & 0xC0) == 0x80;
+}
+
+// Offset of the first byte that does not start a well-formed UTF-8 sequence,
+// or `size` if the whole buffer is valid. Well-formed follows the Unicode
+// table of byte sequences: no overlong forms, no surrogates, nothing past
+// U+10FFFF. Runs of ASCII are checked 16 bytes at a time where SSE2 is
+// available; each multi-byte sequence is then checked by its lead byte.
+inline size_t utf8_invalid_offset(const char* data, size_t size) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t i = 0;
+
+    while (i < size) {
+#if defined(__SSE2__)
+        while (i + 16 <= size) {
+            int high = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i)));
+            if (high != 0) {
+                i += __builtin_ctz(high); // first non-ASCII byte
+                break;
+            }
+            i += 16;
+        }
+        if (i >= size) break;
+#endif
+        unsigned char lead = bytes[i];
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
+
+        // Length and the range allowed for the second byte.
+        size_t length;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead == 0xE0) {
+            length = 3;
+            low = 0xA0;
+        } else if (lead == 0xED) {
+            length = 3;
+            high = 0x9F;
+        } else if (lead >= 0xE1 && lead <= 0xEF) {
+            length = 3;
+        } else if (lead == 0xF0) {
+            length = 4;
+            low = 0x90;
+        } else if (lead == 0xF4) {
+            length = 4;
+            high = 0x8F;
+        } else if (lead >= 0xF1 && lead <= 0xF3) {
+            length = 4;
+        } else {
+            return i;
+        }
+
+        if (size - i < length || bytes[i + 1] < low || bytes[i + 1] > high) return i;
+        for (size_t k = 2; k < length; k++) {
+            if (!utf8_continuation(bytes[i + k])) return i;
+        }
+        i += length;
+    }
+    return size;
+}
+
+// Code point of the sequence starting at `data`, which must be well-formed
+// (see utf8_invalid_offset); its size in bytes is stored in `length`.
+inline char32_t utf8_decode(const char* data, size_t& length) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    unsigned char lead = bytes[0];
+    if (lead < 0x80) {
+        length = 1;
+        return lead;
+    }
+
+    length = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : 2;
+    char32_t code = lead & (0x7F >> length);
+    for (size_t k = 1; k < length; k++) code = (code << 6) | (bytes[k] & 0x3F);
+    return code;
+}
+
+#endif
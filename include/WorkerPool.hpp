@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Allocator.hpp"
+
+// Work-stealing thread pool for script jobs. Each worker owns a deque: it
+// pops its own newest job (LIFO, cache-warm) and, when empty, steals the
+// oldest job from another worker. Jobs submitted from outside are spread
+// round-robin; jobs submitted from inside a job stay on that worker.
+//
+// Each worker runs its jobs under an AllocatorScope for its own
+// TrackingAllocator, so nodes a job creates outside an isolate (which brings
+// its own allocator) are counted per worker. Like any allocated object they
+// must be destroyed before the pool that counted them.
+class WorkerPool {
+public:
+    using Job = std::function<void()>;
+
+    explicit WorkerPool(unsigned threads = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(Job job);
+    // Blocks until every submitted job has finished, then rethrows the first
+    // exception any of them raised. Only for threads outside the pool: the
+    // calling job would count as unfinished, so a job that waits on its own
+    // pool gets std::logic_error instead of a deadlock. Jobs that need to
+    // join their own subtasks use parallel_chunks (ParallelFor.hpp).
+    void wait();
+
+    unsigned size() const { return (unsigned)workers.size(); }
+    // Index of the calling worker in [0, size()), or -1 outside the pool.
+    static int current_worker();
+    // What the jobs on worker `index` allocated through current_allocator().
+    const TrackingAllocator& memory(unsigned index) const { return *allocators[index]; }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::unique_ptr<TrackingAllocator>> allocators;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> pending{0};
+
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    bool stopping = false;
+    std::exception_ptr failure;
+
+    bool take(size_t self, Job& job);
+    void run(size_t self);
+};
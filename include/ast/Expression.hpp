@@ -3,9 +3,17 @@
 #include <vector>
 #include <memory>
 #include "Lexer.hpp"
+#include "Allocator.hpp"
+#include "Stats.hpp"
 
-class Expression {
+// Static types inferred by passes/TypeInference. UNKNOWN is "no information
+// yet" and DYNAMIC is "may be several types at run time".
+enum class ValueType { UNKNOWN, INT, FLOAT, STRING, BOOL, NULL_VALUE, DYNAMIC };
+
+class Expression : public AllocatedObject {
 public:
+    ValueType type = ValueType::UNKNOWN;
+
     virtual ~Expression() = default;
 };
 
@@ -25,6 +33,14 @@ public:
     explicit VariableExpression(std::string name) : name(std::move(name)) {}
 };
 
+class AssignExpression : public Expression {
+public:
+    std::string name;
+    ExprPtr value;
+
+    AssignExpression(std::string name, ExprPtr value) : name(std::move(name)), value(std::move(value)) {}
+};
+
 class UnaryExpression : public Expression {
 public:
     TokenType op;
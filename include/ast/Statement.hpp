@@ -4,8 +4,10 @@
 #include <string>
 #include "Expression.hpp"
 #include "Lexer.hpp"
+#include "Allocator.hpp"
+#include "Stats.hpp"
 
-class Statement {
+class Statement : public AllocatedObject {
 public:
     virtual ~Statement() = default;
 };
@@ -23,6 +25,7 @@ class VariableDeclaration : public Statement {
 public:
     std::string name;
     ExprPtr initializer; // can be nullptr if no initializer
+    ValueType type = ValueType::UNKNOWN; // join of every value it holds
 
     VariableDeclaration(std::string name, ExprPtr initializer)
         : name(std::move(name)), initializer(std::move(initializer)) {}
@@ -66,6 +69,25 @@ public:
         : initializer(std::move(initializer)), condition(std::move(condition)), increment(std::move(increment)), body(std::move(body)) {}
 };
 
+enum class Reduction { NONE, SUM, MIN, MAX, APPEND };
+
+// `parallel for` iterations run in any order on any worker. With a
+// reduction, the target names one iteration's contribution inside the body:
+// whatever the body leaves in it is folded in source order, and an iteration
+// that never assigns it contributes nothing. After the loop the target holds
+// the folded result.
+class ParallelForStatement : public Statement {
+public:
+    std::string variable;
+    ExprPtr iterable; // an int N (0..N-1) or a list
+    Reduction reduction;
+    std::string target; // empty when reduction is NONE
+    StmtPtr body;
+
+    ParallelForStatement(std::string variable, ExprPtr iterable, Reduction reduction, std::string target, StmtPtr body)
+        : variable(std::move(variable)), iterable(std::move(iterable)), reduction(reduction), target(std::move(target)), body(std::move(body)) {}
+};
+
 class ReturnStatement : public Statement {
 public:
     ExprPtr value; // can be nullptr
@@ -73,12 +95,28 @@ public:
     explicit ReturnStatement(ExprPtr value) : value(std::move(value)) {}
 };
 
+class ImportDeclaration : public Statement {
+public:
+    std::string path; // as written; resolved relative to the importing file
+
+    explicit ImportDeclaration(std::string path) : path(std::move(path)) {}
+};
+
 class FunctionDeclaration : public Statement {
 public:
     std::string name;
     std::vector<std::string> parameters;
-    StmtPtr body;
+    StmtPtr body; // nullptr until first call when parsed lazily
+    size_t bodyBegin = 0; // token range of the unparsed body, '{' to past '}'
+    size_t bodyEnd = 0;
+    int line = 0; // line of the name, for diagnostics and profiles
+    std::vector<ValueType> parameterTypes; // joined over call sites; empty until inferred
+    ValueType returnType = ValueType::UNKNOWN;
+    bool memoize = false; // declared `memo function`
+    bool pure = false;    // set by passes/Purity; memoized only when both hold
 
     FunctionDeclaration(std::string name, std::vector<std::string> parameters, StmtPtr body)
         : name(std::move(name)), parameters(std::move(parameters)), body(std::move(body)) {}
+
+    bool isLazy() const { return !body && bodyEnd > bodyBegin; }
 };
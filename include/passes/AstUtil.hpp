@@ -0,0 +1,46 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "ast/Expression.hpp"
+#include "ast/Statement.hpp"
+
+// Shared helpers for the optimization passes. Statement walkers skip the
+// nullptr entries the parser leaves for empty statements, and lazy function
+// bodies are never touched because they have no nodes yet.
+
+ExprPtr clone(const Expression& expression);
+
+// A division, which raises on a zero divisor. The other operators are
+// assumed not to raise. Looks at `expression` itself, not its operands.
+bool may_raise(const Expression& expression);
+
+// No calls, no assignments and nothing that may raise, so evaluating it can
+// be skipped, repeated or moved without changing what the script does.
+bool is_pure(const Expression& expression);
+
+// Node count; the size measure for the inlining budget.
+size_t expression_size(const Expression& expression);
+
+// Direct subexpression slots of `expression`.
+void for_each_child(Expression& expression, const std::function<void(ExprPtr&)>& visit);
+
+// Direct child statement slots of `statement`, skipping empty ones.
+void for_each_child(Statement& statement, const std::function<void(StmtPtr&)>& visit);
+
+// Top-level expression slots of `statement` and of every statement nested in it.
+void for_each_expression(Statement& statement, const std::function<void(ExprPtr&)>& visit);
+
+// Every statement list nested in `statement`, innermost first.
+void for_each_block(Statement& statement, const std::function<void(std::vector<StmtPtr>&)>& visit);
+
+// Names read or assigned anywhere in the subtree, including call targets.
+void collect_names(Expression& expression, std::unordered_set<std::string>& names);
+void collect_names(Statement& statement, std::unordered_set<std::string>& names);
+
+// Script-like rendering, fully parenthesized; for pass reports.
+std::string to_source(const Expression& expression);
+
+// Names a function body binds: parameters, `let`s and loop variables.
+std::unordered_set<std::string> local_names(FunctionDeclaration& function);
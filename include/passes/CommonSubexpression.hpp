@@ -0,0 +1,53 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast/Statement.hpp"
+
+// Common subexpression elimination within basic blocks of function bodies;
+// top-level statements are left alone. A basic block is a run of expression
+// statements and `let`s in one statement list, up to and including the next
+// if condition or return; any other statement ends it. A pure expression
+// that occurs more than once in a block is computed once into a `let __cseN`
+// placed before the statement holding the first occurrence.
+//
+// Two occurrences match only if every variable they read has the same
+// version: assigning any variable or redeclaring a local starts a new
+// version of it, and any call starts a new version of every global. An
+// expression whose inputs its own statement changes is not a candidate.
+// Right operands of `and`/`or` are never moved, so nothing is evaluated that
+// the script would have skipped, and neither are divisions (see may_raise).
+class CommonSubexpression {
+public:
+    // Each elimination is reported as one line on `report` when it is set.
+    explicit CommonSubexpression(std::ostream* report = nullptr) : report(report) {}
+
+    // Returns the number of recomputations removed.
+    size_t run(std::vector<StmtPtr>& program);
+
+private:
+    struct Occurrences {
+        size_t statement; // index of the first occurrence's statement
+        size_t size;
+        std::vector<ExprPtr*> slots;
+    };
+
+    std::ostream* report;
+    size_t eliminated = 0;
+    size_t temporaries = 0;
+    const FunctionDeclaration* function = nullptr;
+    const std::unordered_set<std::string>* locals = nullptr;
+
+    // Per basic block.
+    std::unordered_map<std::string, size_t> versions;
+    size_t globalVersion = 0;
+    std::unordered_map<std::string, Occurrences> occurrences;
+    std::vector<std::string> firstSeen;
+
+    void block(std::vector<StmtPtr>& statements);
+    void collect(ExprPtr& expression, size_t statement, const std::unordered_set<std::string>& written, bool calls);
+    std::string key(const Expression& expression, const std::unordered_set<std::string>& written, bool calls) const;
+    void flush(std::unordered_map<size_t, std::vector<StmtPtr>>& lets);
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <vector>
+#include "ast/Statement.hpp"
+
+// Removes, inside function bodies:
+//  - statements after a `return` in the same block,
+//  - expression statements whose expression is pure,
+//  - `let`s whose name is never read or assigned in the function and whose
+//    initializer is pure (or absent).
+// Repeats until nothing changes, since dropping one `let` can leave the
+// variables it read unused. Top-level declarations are globals and stay.
+class DeadCode {
+public:
+    // Returns the number of statements removed.
+    size_t run(std::vector<StmtPtr>& program);
+
+private:
+    size_t removed = 0;
+
+    bool sweep(FunctionDeclaration& function);
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast/Statement.hpp"
+
+// Replaces calls to small top-level functions with the function's result
+// expression. A function qualifies when its body is a single
+// `return expression;` of at most `budget` nodes and its name is never
+// reassigned or redeclared at top level.
+//
+// A call site is expanded only when every argument is pure, and a parameter
+// used more than once receives only a literal or a variable, so nothing is
+// dropped or computed twice. Calls are also skipped when the caller binds a
+// name that the callee's body reads as a global. Recursive calls, direct or
+// mutual, are never expanded: a function is not inlined into its own
+// expansion.
+class Inliner {
+public:
+    explicit Inliner(size_t budget = 24) : budget(budget) {}
+
+    // Returns the number of call sites replaced.
+    size_t run(std::vector<StmtPtr>& program);
+
+private:
+    size_t budget;
+    size_t inlined = 0;
+    // Qualifying functions by name. Their results are read at each call
+    // site, since inlining into a candidate's own body can change them.
+    std::unordered_map<std::string, const FunctionDeclaration*> candidates;
+    std::vector<std::string> expanding;
+    const std::unordered_set<std::string>* locals = nullptr;
+
+    void find_candidates(std::vector<StmtPtr>& program);
+    void rewrite(ExprPtr& expression);
+    bool can_inline(const FunctionDeclaration& function, const std::vector<ExprPtr>& arguments) const;
+};
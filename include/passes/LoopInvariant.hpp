@@ -0,0 +1,40 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "ast/Statement.hpp"
+
+// Loop-invariant code motion. In every while, for and parallel for loop of a
+// function body, the largest pure subexpressions whose inputs the loop
+// cannot change are computed once into `let __licmN` temporaries placed
+// before the loop. The loop and its temporaries are wrapped in a block.
+// Loops in top-level statements are left alone: every name there is a
+// global, which any call may change.
+//
+// The loop can change a variable if it assigns it or declares it (including
+// the loop variable and a for initializer). Any call in the loop can also
+// change every global, but never the caller's locals. Divisions are never
+// hoisted (see is_pure), since a zero divisor would then raise even when the
+// loop body never runs.
+//
+// Inner loops are processed first, so an invariant can move out through
+// several levels.
+class LoopInvariant {
+public:
+    // Each hoist is reported as one line on `report` when it is set.
+    explicit LoopInvariant(std::ostream* report = nullptr) : report(report) {}
+
+    // Returns the number of expressions hoisted.
+    size_t run(std::vector<StmtPtr>& program);
+
+private:
+    std::ostream* report;
+    size_t hoisted = 0;
+    size_t temporaries = 0;
+    const FunctionDeclaration* function = nullptr;
+    const std::unordered_set<std::string>* locals = nullptr;
+
+    void visit(StmtPtr& statement);
+    void hoist(StmtPtr& loop);
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <iosfwd>
+#include <vector>
+#include "ast/Statement.hpp"
+
+struct OptimizerOptions {
+    bool inlining = true;
+    size_t inlineBudget = 24; // max nodes in an inlined result expression
+    bool cse = true;
+    bool licm = true;
+    bool deadCode = true;
+    std::ostream* report = nullptr; // one line per CSE and LICM rewrite, and per memo function left unmemoized
+};
+
+// Runs the enabled AST passes over a parsed program, in place. Inlining goes
+// first to expose more expressions, CSE runs before LICM so the temporaries it
+// introduces inside loops can be hoisted, and the dead-code pass cleans up
+// last. Purity always runs at the end, on the final bodies, to decide which
+// `memo` functions get a result cache.
+void optimize(std::vector<StmtPtr>& program, const OptimizerOptions& options = {});
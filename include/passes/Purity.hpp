@@ -0,0 +1,47 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ast/Statement.hpp"
+
+// Marks functions whose result depends only on their arguments, so a call
+// can be answered from a cache (see MemoCache.hpp). A function is pure when
+// its body is parsed and it
+//   - assigns only its own parameters, `let`s and loop variables,
+//   - reads no global that is assigned anywhere or declared more than once,
+//   - calls only top-level functions that are themselves pure; a call to
+//     anything else, builtins and imports included, may have effects.
+// A name that is both bound in the function and a mutable global is treated
+// as the global, since scoping is not tracked here. Recursion, direct or
+// mutual, is allowed: the analysis starts from "every parsed function is
+// pure" and removes functions until nothing changes.
+//
+// Lazy bodies count as impure, and since one may assign any global, no
+// function is pure while any body in the program is still lazy. Running the
+// pass again after they are parsed can only mark more functions pure.
+class Purity {
+public:
+    // Each `memo function` that is not pure is reported with the reason as
+    // one line on `report` when it is set.
+    explicit Purity(std::ostream* report = nullptr) : report(report) {}
+
+    // Sets FunctionDeclaration::pure throughout the program and returns the
+    // number of `memo` functions that will be memoized.
+    size_t run(std::vector<StmtPtr>& program);
+
+private:
+    std::ostream* report;
+    // Top-level functions declared once and never assigned.
+    std::unordered_map<std::string, FunctionDeclaration*> functions;
+    // Top-level `let`s declared once and never assigned.
+    std::unordered_set<std::string> constants;
+    // Top-level names assigned anywhere or declared more than once.
+    std::unordered_set<std::string> mutableGlobals;
+    // Some top-level function body is not parsed yet.
+    bool lazyBodies = false;
+
+    void find_globals(std::vector<StmtPtr>& program);
+    std::string impurity(FunctionDeclaration& function) const;
+};
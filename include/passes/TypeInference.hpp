@@ -0,0 +1,60 @@
+#pragma once
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast/Statement.hpp"
+
+// Flow-sensitive type inference. Literal types flow through variables,
+// assignments, arithmetic, call arguments and return values. Every
+// expression, `let` and function signature is annotated with the result.
+//
+// Within a function, each variable's type is tracked statement by statement.
+// Branches are joined where they meet, and loops are iterated to a fixed
+// point. Across functions, a parameter takes the join of the arguments at
+// every call site in the program, and the whole program is re-analysed until
+// no signature changes. Globals are flow-insensitive: a global has the join
+// of every value assigned to it anywhere.
+//
+// A `let` or parameter whose type ends up INT or FLOAT is monomorphic and
+// can live in an unboxed slot. Arithmetic whose operands are both known
+// numeric types needs no runtime type check. Parameters assume every call
+// comes from the analysed program, so a call from elsewhere (an importer, the
+// embedding API) must check its arguments on entry. Functions that are never
+// called here, whose bodies are still lazy, or whose name is read as a value
+// (and so may be called from anywhere) get DYNAMIC parameters.
+class TypeInference {
+public:
+    void run(std::vector<StmtPtr>& program);
+
+private:
+    struct Binding {
+        ValueType type;
+        VariableDeclaration* declaration; // nullptr for parameters and loop variables
+    };
+    // Innermost scope last.
+    using Environment = std::vector<std::unordered_map<std::string, Binding>>;
+
+    std::unordered_map<std::string, FunctionDeclaration*> functions;
+    std::unordered_map<std::string, VariableDeclaration*> globals;
+    FunctionDeclaration* current = nullptr;
+    bool changed = false; // a signature or global grew; run again
+
+    ValueType infer(Expression& expression, Environment& environment);
+    void analyse(Statement& statement, Environment& environment);
+    void analyse_scoped(Statement& statement, Environment& environment);
+    void analyse_loop(Expression* condition, Statement* body, Expression* increment, Environment& environment);
+    void analyse_parallel(ParallelForStatement& loop, Environment& environment);
+    void assign(const std::string& name, ValueType type, Environment& environment);
+
+    static Binding* lookup(Environment& environment, const std::string& name);
+    static bool merge(Environment& environment, const Environment& other);
+    static bool widen(ValueType& target, ValueType type);
+};
+
+ValueType join(ValueType a, ValueType b);
+const char* type_name(ValueType type);
+bool is_unboxed(ValueType type);
+
+// One line per function signature and per `let`, for --types.
+void dump_types(const std::vector<StmtPtr>& program, std::ostream& out);
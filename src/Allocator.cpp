@@ -0,0 +1,225 @@
+#include "Allocator.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <string>
+
+// --- Heap ---
+namespace {
+
+// Plain new for ordinary alignments, so replacements of the global
+// operator new (the allocation counter in Stats.cpp) still see every node.
+class HeapAllocator : public Allocator {
+public:
+    void* allocate(size_t size, size_t alignment) override {
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) return ::operator new(size);
+        return ::operator new(size, std::align_val_t(alignment));
+    }
+
+    void deallocate(void* pointer, size_t, size_t alignment) noexcept override {
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(pointer);
+        } else {
+            ::operator delete(pointer, std::align_val_t(alignment));
+        }
+    }
+};
+
+} // namespace
+
+Allocator& default_allocator() {
+    static HeapAllocator heap;
+    return heap;
+}
+
+MemoryBudgetExceeded::MemoryBudgetExceeded(size_t requested, size_t live, size_t budget)
+    : std::runtime_error("Memory budget exceeded: " + std::to_string(requested) + " bytes requested with " +
+                         std::to_string(live) + " of " + std::to_string(budget) + " in use"),
+      requested(requested), live(live), budget(budget) {}
+
+// --- Arena ---
+ArenaAllocator::ArenaAllocator(Allocator& upstream, size_t blockSize) : upstream(upstream), blockSize(blockSize) {}
+
+ArenaAllocator::~ArenaAllocator() {
+    reset();
+}
+
+void* ArenaAllocator::allocate(size_t size, size_t alignment) {
+    uintptr_t aligned = ((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (!cursor || aligned + size > (uintptr_t)limit) {
+        // Oversized requests get a block of their own.
+        size_t bytes = std::max(blockSize, size + alignment);
+        char* data = static_cast<char*>(upstream.allocate(bytes));
+        blocks.push_back(Block{data, bytes});
+        cursor = data;
+        limit = data + bytes;
+        aligned = ((uintptr_t)cursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    }
+
+    cursor = reinterpret_cast<char*>(aligned + size);
+    bytesUsed += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+void ArenaAllocator::reset() {
+    for (const Block& block : blocks) upstream.deallocate(block.data, block.size);
+    blocks.clear();
+    cursor = limit = nullptr;
+    bytesUsed = 0;
+}
+
+// --- Pool ---
+constexpr size_t PoolAllocator::classSizes[];
+
+PoolAllocator::PoolAllocator(Allocator& upstream, size_t chunkSize) : upstream(upstream), chunkSize(chunkSize) {}
+
+PoolAllocator::~PoolAllocator() {
+    for (void* chunk : chunks) upstream.deallocate(chunk, chunkSize);
+}
+
+// Index of the smallest class that fits, or CLASS_COUNT.
+size_t PoolAllocator::size_class(size_t size) {
+    return std::lower_bound(classSizes, classSizes + CLASS_COUNT, size) - classSizes;
+}
+
+void* PoolAllocator::allocate(size_t size, size_t alignment) {
+    size_t index = size_class(size);
+    if (index == CLASS_COUNT || alignment > alignof(std::max_align_t)) return upstream.allocate(size, alignment);
+
+    if (FreeSlot* slot = freeLists[index]) {
+        freeLists[index] = slot->next;
+        return slot;
+    }
+
+    // Every class size is a multiple of 16, so slots carved in sequence
+    // stay max-aligned.
+    size_t slotSize = classSizes[index];
+    if (!cursor || (size_t)(limit - cursor) < slotSize) {
+        cursor = static_cast<char*>(upstream.allocate(chunkSize));
+        limit = cursor + chunkSize;
+        chunks.push_back(cursor);
+    }
+    void* slot = cursor;
+    cursor += slotSize;
+    return slot;
+}
+
+void PoolAllocator::deallocate(void* pointer, size_t size, size_t alignment) noexcept {
+    size_t index = size_class(size);
+    if (index == CLASS_COUNT || alignment > alignof(std::max_align_t)) {
+        upstream.deallocate(pointer, size, alignment);
+        return;
+    }
+
+    FreeSlot* slot = static_cast<FreeSlot*>(pointer);
+    slot->next = freeLists[index];
+    freeLists[index] = slot;
+}
+
+// --- Tracking ---
+TrackingAllocator::TrackingAllocator(Allocator& upstream, size_t budget) : upstream(upstream), limit(budget) {}
+
+void* TrackingAllocator::allocate(size_t size, size_t alignment) {
+    // Reserve first, so concurrent allocations cannot overshoot together.
+    size_t live = liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    if (live > limit) {
+        liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        throw MemoryBudgetExceeded(size, live - size, limit);
+    }
+
+    void* pointer;
+    try {
+        pointer = upstream.allocate(size, alignment);
+    } catch (...) {
+        liveBytes.fetch_sub(size, std::memory_order_relaxed);
+        throw;
+    }
+
+    size_t phase = (size_t)current.load(std::memory_order_relaxed);
+    phaseAllocations[phase].fetch_add(1, std::memory_order_relaxed);
+    phaseBytes[phase].fetch_add(size, std::memory_order_relaxed);
+    size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return pointer;
+}
+
+void TrackingAllocator::deallocate(void* pointer, size_t size, size_t alignment) noexcept {
+    liveBytes.fetch_sub(size, std::memory_order_relaxed);
+    upstream.deallocate(pointer, size, alignment);
+}
+
+Phase TrackingAllocator::enter(Phase phase) {
+    return current.exchange(phase, std::memory_order_relaxed);
+}
+
+void TrackingAllocator::report(std::ostream& out) const {
+    std::ios_base::fmtflags flags = out.flags();
+
+    out << std::left << std::setw(24) << "phase" << std::right << std::setw(14) << "allocations" << std::setw(14) << "bytes" << "\n";
+    for (size_t i = 0; i < (size_t)Phase::COUNT; i++) {
+        if (!allocations((Phase)i)) continue;
+        out << std::left << std::setw(24) << phase_name((Phase)i) << std::right << std::setw(14) << allocations((Phase)i)
+            << std::setw(14) << bytes((Phase)i) << "\n";
+    }
+    out << std::left << std::setw(24) << "live (bytes)" << std::right << std::setw(14) << live() << "\n";
+    out << std::left << std::setw(24) << "peak (bytes)" << std::right << std::setw(14) << peak() << "\n";
+    if (limit != SIZE_MAX) {
+        out << std::left << std::setw(24) << "budget (bytes)" << std::right << std::setw(14) << limit << "\n";
+    }
+
+    out.flags(flags);
+}
+
+// --- Synchronized ---
+void* SynchronizedAllocator::allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> guard(lock);
+    return upstream.allocate(size, alignment);
+}
+
+void SynchronizedAllocator::deallocate(void* pointer, size_t size, size_t alignment) noexcept {
+    std::lock_guard<std::mutex> guard(lock);
+    upstream.deallocate(pointer, size, alignment);
+}
+
+// --- Current allocator ---
+static thread_local Allocator* currentAllocator = nullptr;
+
+Allocator& current_allocator() {
+    return currentAllocator ? *currentAllocator : default_allocator();
+}
+
+AllocatorScope::AllocatorScope(Allocator& allocator) : previous(currentAllocator) {
+    currentAllocator = &allocator;
+}
+
+AllocatorScope::~AllocatorScope() {
+    currentAllocator = previous;
+}
+
+// --- Allocated objects ---
+// A header in front of each object records where it came from and how big
+// the request was. It is max-aligned, so the object after it is too.
+namespace {
+
+struct alignas(std::max_align_t) ObjectHeader {
+    Allocator* owner;
+    size_t size;
+};
+
+} // namespace
+
+void* AllocatedObject::operator new(size_t size) {
+    Allocator& allocator = current_allocator();
+    size_t total = sizeof(ObjectHeader) + size;
+    auto* header = static_cast<ObjectHeader*>(allocator.allocate(total));
+    header->owner = &allocator;
+    header->size = total;
+    return header + 1;
+}
+
+void AllocatedObject::operator delete(void* pointer) noexcept {
+    if (!pointer) return;
+    ObjectHeader* header = static_cast<ObjectHeader*>(pointer) - 1;
+    header->owner->deallocate(header, header->size);
+}
@@ -0,0 +1,229 @@
+#include "Dump.hpp"
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+static const char TOKENS_MAGIC[8] = {'A', 'G', 'T', 'O', 'K', '\0', '\0', '\0'};
+static const char AST_MAGIC[8] = {'A', 'G', 'A', 'S', 'T', '\0', '\0', '\0'};
+
+// --- Output buffer ---
+OutputBuffer::OutputBuffer(int fd, size_t capacity) : fd(fd), buffer(capacity) {}
+
+OutputBuffer::~OutputBuffer() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void OutputBuffer::write(const char* data, size_t size) {
+    while (size > 0) {
+        if (used == buffer.size()) flush();
+        size_t n = std::min(size, buffer.size() - used);
+        std::memcpy(buffer.data() + used, data, n);
+        used += n;
+        data += n;
+        size -= n;
+    }
+}
+
+void OutputBuffer::write(long long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    write(digits, result.ptr - digits);
+}
+
+void OutputBuffer::flush() {
+    size_t done = 0;
+    while (done < used) {
+        ssize_t n = ::write(fd, buffer.data() + done, used - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            used = 0;
+            throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+        }
+        done += n;
+    }
+    used = 0;
+}
+
+// --- Tokens ---
+void dump_tokens_text(const std::vector<Token>& tokens, OutputBuffer& out) {
+    for (const Token& token : tokens) {
+        out.write("Token: ");
+        out.write(token_name(token.type));
+        out.write(", Value: '");
+        out.write(token.value);
+        out.write("', Line: ");
+        out.write((long long)token.line);
+        out.write(", Col: ");
+        out.write((long long)token.column);
+        out.write("\n");
+    }
+}
+
+// Header, records and pool, in that order; records start right after the
+// header, which keeps them 8-byte aligned.
+template <typename T>
+static void write_image(const char (&magic)[8], const std::vector<T>& records, const StringPool& strings, OutputBuffer& out) {
+    static_assert(sizeof(DumpHeader) % alignof(T) == 0, "records follow the header unpadded");
+    if (records.size() > UINT32_MAX) {
+        throw std::runtime_error("Too many records for a dump");
+    }
+
+    DumpHeader header{};
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.version = DUMP_VERSION;
+    header.recordCount = (uint32_t)records.size();
+    header.stringsSize = (uint32_t)strings.data().size();
+    header.records = sizeof(DumpHeader);
+    header.strings = header.records + records.size() * sizeof(T);
+
+    out.write_records(&header, 1);
+    out.write_records(records.data(), records.size());
+    out.write(strings.data());
+}
+
+void dump_tokens_binary(const std::vector<Token>& tokens, OutputBuffer& out) {
+    StringPool strings;
+    std::vector<TokenRecord> records;
+    records.reserve(tokens.size());
+    for (const auto& token : tokens) records.push_back(to_record(token, strings));
+    write_image(TOKENS_MAGIC, records, strings, out);
+}
+
+// --- AST ---
+namespace {
+
+class AstWriter {
+public:
+    std::vector<AstRecord> records;
+    StringPool strings;
+
+    void add(const Expression* expression) {
+        size_t index = open(AstKind::EMPTY);
+        if (auto* literal = dynamic_cast<const LiteralExpression*>(expression)) {
+            records[index].kind = AstKind::LITERAL;
+            records[index].op = (uint16_t)literal->literal.type;
+            records[index].text = strings.add(literal->literal.value);
+        } else if (auto* variable = dynamic_cast<const VariableExpression*>(expression)) {
+            records[index].kind = AstKind::VARIABLE;
+            records[index].text = strings.add(variable->name);
+        } else if (auto* assign = dynamic_cast<const AssignExpression*>(expression)) {
+            records[index].kind = AstKind::ASSIGN;
+            records[index].text = strings.add(assign->name);
+            add(assign->value.get());
+        } else if (auto* unary = dynamic_cast<const UnaryExpression*>(expression)) {
+            records[index].kind = AstKind::UNARY;
+            records[index].op = (uint16_t)unary->op;
+            add(unary->right.get());
+        } else if (auto* binary = dynamic_cast<const BinaryExpression*>(expression)) {
+            records[index].kind = AstKind::BINARY;
+            records[index].op = (uint16_t)binary->op;
+            add(binary->left.get());
+            add(binary->right.get());
+        } else if (auto* call = dynamic_cast<const CallExpression*>(expression)) {
+            records[index].kind = AstKind::CALL;
+            records[index].count = (uint32_t)call->arguments.size();
+            add(call->callee.get());
+            for (const auto& argument : call->arguments) add(argument.get());
+        }
+        close(index);
+    }
+
+    void add(const Statement* statement) {
+        size_t index = open(AstKind::EMPTY);
+        if (auto* expression = dynamic_cast<const ExpressionStatement*>(statement)) {
+            records[index].kind = AstKind::EXPRESSION;
+            add(expression->expression.get());
+        } else if (auto* variable = dynamic_cast<const VariableDeclaration*>(statement)) {
+            records[index].kind = AstKind::LET;
+            records[index].text = strings.add(variable->name);
+            add(variable->initializer.get());
+        } else if (auto* block = dynamic_cast<const BlockStatement*>(statement)) {
+            records[index].kind = AstKind::BLOCK;
+            records[index].count = (uint32_t)block->statements.size();
+            for (const auto& child : block->statements) add(child.get());
+        } else if (auto* branch = dynamic_cast<const IfStatement*>(statement)) {
+            records[index].kind = AstKind::IF;
+            add(branch->condition.get());
+            add(branch->thenBranch.get());
+            add(branch->elseBranch.get());
+        } else if (auto* whileLoop = dynamic_cast<const WhileStatement*>(statement)) {
+            records[index].kind = AstKind::WHILE;
+            add(whileLoop->condition.get());
+            add(whileLoop->body.get());
+        } else if (auto* forLoop = dynamic_cast<const ForStatement*>(statement)) {
+            records[index].kind = AstKind::FOR;
+            add(forLoop->initializer.get());
+            add(forLoop->condition.get());
+            add(forLoop->increment.get());
+            add(forLoop->body.get());
+        } else if (auto* parallelLoop = dynamic_cast<const ParallelForStatement*>(statement)) {
+            records[index].kind = AstKind::PARALLEL_FOR;
+            records[index].op = (uint16_t)parallelLoop->reduction;
+            records[index].text = strings.add(parallelLoop->variable);
+            records[index].target = strings.add(parallelLoop->target);
+            add(parallelLoop->iterable.get());
+            add(parallelLoop->body.get());
+        } else if (auto* result = dynamic_cast<const ReturnStatement*>(statement)) {
+            records[index].kind = AstKind::RETURN;
+            add(result->value.get());
+        } else if (auto* import = dynamic_cast<const ImportDeclaration*>(statement)) {
+            records[index].kind = AstKind::IMPORT;
+            records[index].text = strings.add(import->path);
+        } else if (auto* function = dynamic_cast<const FunctionDeclaration*>(statement)) {
+            records[index].kind = AstKind::FUNCTION;
+            records[index].text = strings.add(function->name);
+            records[index].count = (uint32_t)function->parameters.size();
+            records[index].flags = (function->memoize ? AST_MEMO : 0) | (function->isLazy() ? AST_LAZY : 0);
+            for (const auto& parameter : function->parameters) {
+                size_t slot = open(AstKind::PARAMETER);
+                records[slot].text = strings.add(parameter);
+                close(slot);
+            }
+            add(function->body.get());
+        }
+        close(index);
+    }
+
+private:
+    size_t open(AstKind kind) {
+        AstRecord record{};
+        record.kind = kind;
+        records.push_back(record);
+        return records.size() - 1;
+    }
+
+    void close(size_t index) { records[index].end = (uint32_t)records.size(); }
+};
+
+} // namespace
+
+void dump_ast_binary(const std::vector<StmtPtr>& program, OutputBuffer& out) {
+    AstWriter writer;
+    for (const auto& statement : program) writer.add(statement.get());
+    write_image(AST_MAGIC, writer.records, writer.strings, out);
+}
+
+// --- Reading ---
+DumpImage::DumpImage(const std::string& path, Kind kind) : file(path) {
+    head = file.records<DumpHeader>(0, 1);
+    const char* magic = kind == Kind::TOKENS ? TOKENS_MAGIC : AST_MAGIC;
+    if (!head || std::memcmp(head->magic, magic, sizeof(head->magic)) != 0) {
+        throw std::runtime_error(std::string(kind == Kind::TOKENS ? "Not a token dump: " : "Not an AST dump: ") + path);
+    }
+    if (head->version != DUMP_VERSION) {
+        throw std::runtime_error("Unsupported dump version: " + path);
+    }
+
+    records = kind == Kind::TOKENS ? (const void*)file.records<TokenRecord>(head->records, head->recordCount)
+                                   : (const void*)file.records<AstRecord>(head->records, head->recordCount);
+    const char* strings = file.records<char>(head->strings, head->stringsSize);
+    if (!records || !strings) {
+        throw std::runtime_error("Truncated dump: " + path);
+    }
+    pool = std::string_view(strings, head->stringsSize);
+}
@@ -0,0 +1,259 @@
+#include "EventLoop.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+static uint64_t monotonic_now() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+EventLoop::EventLoop(WorkerPool* blocking) : blocking(blocking) {
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epoll < 0 || wakeFd < 0 || timerFd < 0) {
+        throw std::runtime_error("Could not create event loop");
+    }
+
+    for (int fd : {wakeFd, timerFd}) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+    }
+}
+
+EventLoop::~EventLoop() {
+    {
+        std::unique_lock<std::mutex> guard(offloads->lock);
+        offloads->closing = true;
+        offloads->idle.wait(guard, [this]() { return offloads->running == 0; });
+    }
+
+    for (const auto& reader : readers) {
+        epoll_ctl(epoll, EPOLL_CTL_DEL, reader.first, nullptr);
+    }
+    close(timerFd);
+    close(wakeFd);
+    close(epoll);
+}
+
+void EventLoop::complete(Completion& done, Result result) {
+    pending--;
+    Completion callback = std::move(done);
+    callback(std::move(result));
+}
+
+// --- Files ---
+// A job counts as running from the moment it sees the loop open until it has
+// posted its completion, so the destructor knows when no job can reach
+// `this` any more. Jobs that start after the loop began closing return
+// without touching it; the destructor does not wait for them.
+void EventLoop::offload(std::function<Result()> work, Completion done) {
+    pending++;
+    auto finish = [this, offloads = offloads, work = std::move(work), done = std::move(done)]() mutable {
+        {
+            std::lock_guard<std::mutex> guard(offloads->lock);
+            if (offloads->closing) return;
+            offloads->running++;
+        }
+
+        Result result = work();
+        post([this, result = std::move(result), done = std::move(done)]() mutable {
+            complete(done, std::move(result));
+        });
+
+        std::lock_guard<std::mutex> guard(offloads->lock);
+        if (--offloads->running == 0) offloads->idle.notify_all();
+    };
+
+    if (blocking) {
+        blocking->submit(std::move(finish));
+    } else {
+        finish();
+    }
+}
+
+void EventLoop::read_file(std::string path, Completion done) {
+    offload([path = std::move(path)]() {
+        Result result;
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            result.error = errno;
+            return result;
+        }
+
+        char buffer[65536];
+        ssize_t count;
+        while ((count = ::read(fd, buffer, sizeof(buffer))) != 0) {
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                result.error = errno;
+                break;
+            }
+            result.data.append(buffer, count);
+        }
+        close(fd);
+        return result;
+    }, std::move(done));
+}
+
+void EventLoop::write_file(std::string path, std::string data, Completion done) {
+    offload([path = std::move(path), data = std::move(data)]() {
+        Result result;
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            result.error = errno;
+            return result;
+        }
+
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t count = ::write(fd, data.data() + written, data.size() - written);
+            if (count < 0) {
+                if (errno == EINTR) continue;
+                result.error = errno;
+                break;
+            }
+            written += count;
+        }
+        close(fd);
+        return result;
+    }, std::move(done));
+}
+
+// --- Timers ---
+// All sleeps share one timerfd armed for the earliest deadline.
+void EventLoop::sleep(long milliseconds, Completion done) {
+    pending++;
+    uint64_t deadline = monotonic_now() + (uint64_t)std::max(0L, milliseconds) * 1000000ull;
+    bool earliest = timers.empty() || deadline < timers.top().deadline;
+    timers.push(Timer{deadline, timerSequence++, std::move(done)});
+    if (earliest) arm_timer();
+}
+
+void EventLoop::arm_timer() {
+    itimerspec spec{};
+    if (!timers.empty()) {
+        // A zero it_value disarms the timer, so due deadlines fire in 1ns.
+        uint64_t deadline = std::max<uint64_t>(timers.top().deadline, 1);
+        spec.it_value.tv_sec = deadline / 1000000000ull;
+        spec.it_value.tv_nsec = deadline % 1000000000ull;
+    }
+    timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+void EventLoop::fire_timers() {
+    uint64_t expirations;
+    while (::read(timerFd, &expirations, sizeof(expirations)) > 0) {}
+
+    uint64_t now = monotonic_now();
+    while (!timers.empty() && timers.top().deadline <= now) {
+        Timer timer = timers.top();
+        timers.pop();
+        complete(timer.done, Result{});
+    }
+    arm_timer();
+}
+
+// --- Sockets and pipes ---
+// Failures still complete through the loop, never inside the call.
+void EventLoop::read(int fd, size_t max, Completion done) {
+    pending++;
+    auto fail = [this, &done](int error) {
+        post([this, error, done = std::move(done)]() mutable { complete(done, Result{error, ""}); });
+    };
+
+    if (readers.count(fd)) {
+        fail(EBUSY);
+        return;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        fail(errno);
+        return;
+    }
+
+    readers.emplace(fd, Reader{std::max<size_t>(1, max), std::move(done)});
+}
+
+void EventLoop::on_readable(int fd) {
+    auto it = readers.find(fd);
+    if (it == readers.end()) return;
+
+    Result result;
+    result.data.resize(it->second.max);
+    ssize_t count = ::read(fd, &result.data[0], result.data.size());
+    if (count < 0 && (errno == EAGAIN || errno == EINTR)) return; // spurious; keep waiting
+
+    if (count < 0) {
+        result.error = errno;
+        result.data.clear();
+    } else {
+        result.data.resize(count);
+    }
+
+    epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+    Completion done = std::move(it->second.done);
+    readers.erase(it);
+    complete(done, std::move(result));
+}
+
+// --- Dispatch ---
+void EventLoop::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> guard(postLock);
+        posted.push_back(std::move(task));
+    }
+    // Only fails when the counter would overflow, i.e. the loop is already awake.
+    uint64_t one = 1;
+    if (::write(wakeFd, &one, sizeof(one)) < 0) return;
+}
+
+void EventLoop::drain_posted() {
+    uint64_t count;
+    while (::read(wakeFd, &count, sizeof(count)) > 0) {}
+
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> guard(postLock);
+        tasks.swap(posted);
+    }
+    for (auto& task : tasks) task();
+}
+
+void EventLoop::run() {
+    epoll_event events[256];
+
+    while (pending > 0) {
+        int ready = epoll_wait(epoll, events, 256, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("epoll_wait failed");
+        }
+
+        for (int i = 0; i < ready; i++) {
+            int fd = events[i].data.fd;
+            if (fd == wakeFd) {
+                drain_posted();
+            } else if (fd == timerFd) {
+                fire_timers();
+            } else {
+                on_readable(fd);
+            }
+        }
+    }
+}
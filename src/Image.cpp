@@ -0,0 +1,75 @@
+#include "Image.hpp"
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// --- String pool ---
+StringRef StringPool::add(std::string_view text) {
+    auto it = refs.find(std::string(text));
+    if (it != refs.end()) return it->second;
+
+    if (bytes.size() + text.size() > UINT32_MAX) {
+        throw std::runtime_error("String pool exceeds 4 GiB");
+    }
+    StringRef ref{(uint32_t)bytes.size(), (uint32_t)text.size()};
+    bytes.append(text);
+    refs.emplace(text, ref);
+    return ref;
+}
+
+// --- Token records ---
+TokenRecord to_record(const Token& token, StringPool& strings) {
+    TokenRecord record{};
+    record.offset = token.offset;
+    record.value = strings.add(token.value);
+    record.line = token.line;
+    record.column = token.column;
+    record.type = (uint16_t)token.type;
+    return record;
+}
+
+Token from_record(const TokenRecord& record, std::string_view strings) {
+    if (record.type > (uint16_t)TokenType::UNKNOWN || record.value.offset > strings.size() ||
+        record.value.length > strings.size() - record.value.offset) {
+        throw std::runtime_error("Corrupt token record");
+    }
+
+    Token token;
+    token.type = (TokenType)record.type;
+    token.value.assign(strings.data() + record.value.offset, record.value.length);
+    token.line = record.line;
+    token.column = record.column;
+    token.offset = record.offset;
+    return token;
+}
+
+// --- Mapped files ---
+MappedFile::MappedFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + path);
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Could not stat file: " + path);
+    }
+
+    length = info.st_size;
+    if (length > 0) {
+        address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            address = nullptr;
+            close(fd);
+            throw std::runtime_error("Could not map file: " + path);
+        }
+    }
+    close(fd); // the mapping keeps the file alive
+}
+
+MappedFile::~MappedFile() {
+    if (address) munmap(address, length);
+}
@@ -0,0 +1,315 @@
+#include "Incremental.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+// --- Re-lexing ---
+RelexResult relex(const std::string& source, std::vector<Token>& tokens, const TextEdit& edit) {
+    const long delta = (long)edit.inserted.size() - (long)edit.removed;
+    const size_t editEnd = edit.offset + edit.inserted.size();
+    if (editEnd > source.size() || (long)source.size() - delta < (long)(edit.offset + edit.removed)) {
+        throw std::out_of_range("Edit is past the end of the source");
+    }
+
+    auto startsBefore = [](const Token& token, size_t offset) { return token.offset < offset; };
+
+    // The lexer looks at most two bytes past a token ("1." needs the digit
+    // after the dot), so a token can change when the edit starts up to two
+    // bytes after it ends. The two tokens before the edit cover at least that
+    // much, so lexing restarts at the first of them.
+    size_t begin = std::lower_bound(tokens.begin(), tokens.end(), edit.offset, startsBefore) - tokens.begin();
+    begin = begin > 2 ? begin - 2 : 0;
+
+    size_t position = 0;
+    int line = 1;
+    int column = 1;
+    if (begin > 0) {
+        position = tokens[begin].offset;
+        line = tokens[begin].line;
+        column = tokens[begin].column;
+    }
+
+    Lexer lexer(source, position, line, column);
+    std::vector<Token> fresh;
+    size_t resume = tokens.size();
+    size_t candidate = begin;
+    Token token;
+
+    while (true) {
+        token = lexer.getNextToken();
+
+        // Past the edit the text is unchanged, so once a new token matches an
+        // old one at the same place both streams agree from there on.
+        if (token.offset >= editEnd) {
+            size_t oldOffset = token.offset - delta;
+            candidate = std::lower_bound(tokens.begin() + candidate, tokens.end(), oldOffset, startsBefore) - tokens.begin();
+            if (candidate < tokens.size() && tokens[candidate].offset == oldOffset &&
+                tokens[candidate].type == token.type && tokens[candidate].value == token.value) {
+                resume = candidate;
+                break;
+            }
+        }
+
+        fresh.push_back(token);
+        if (token.type == TokenType::END_OF_FILE) break;
+    }
+
+    // Move the reused tail to its new position. Columns only change on the
+    // line where lexing resynchronized.
+    if (resume < tokens.size()) {
+        const int anchorLine = tokens[resume].line;
+        const int lineShift = token.line - anchorLine;
+        const int columnShift = token.column - tokens[resume].column;
+        for (size_t i = resume; i < tokens.size(); i++) {
+            if (tokens[i].line == anchorLine) tokens[i].column += columnShift;
+            tokens[i].line += lineShift;
+            tokens[i].offset += delta;
+        }
+    }
+
+    size_t replaced = resume - begin;
+    size_t overlap = std::min(replaced, fresh.size());
+    std::move(fresh.begin(), fresh.begin() + overlap, tokens.begin() + begin);
+    if (fresh.size() > replaced) {
+        tokens.insert(tokens.begin() + resume, std::make_move_iterator(fresh.begin() + overlap), std::make_move_iterator(fresh.end()));
+    } else {
+        tokens.erase(tokens.begin() + begin + overlap, tokens.begin() + resume);
+    }
+
+    return RelexResult{begin, resume, begin + fresh.size()};
+}
+
+// --- Document ---
+static bool is_declaration(TokenType type) {
+    return type == TokenType::FUNCTION || type == TokenType::LET || type == TokenType::IMPORT || type == TokenType::MEMO;
+}
+
+static bool ends_statement(TokenType type) {
+    return type == TokenType::SEMI_COLON || type == TokenType::RIGHT_BRACE;
+}
+
+// Bracket depth after `token`, counted the same way as
+// Parser::split_top_level.
+static int bracket_depth(int depth, const Token& token) {
+    switch (token.type) {
+        case TokenType::LEFT_BRACE:
+        case TokenType::LEFT_BRACKET:
+        case TokenType::LEFT_PARENTHESIS:
+            return depth + 1;
+        case TokenType::RIGHT_BRACE:
+        case TokenType::RIGHT_BRACKET:
+        case TokenType::RIGHT_PARENTHESIS:
+            return depth > 0 ? depth - 1 : 0;
+        default:
+            return depth;
+    }
+}
+
+IncrementalDocument::IncrementalDocument(std::string source, bool lazyFunctions) : length(source.size()), lazyFunctions(lazyFunctions) {
+    Lexer lexer(source);
+    std::vector<Token> stream;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        stream.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+
+    parts = make_segments(source, std::move(stream), true);
+    origins.resize(parts.size());
+    origins[0] = Position{0, 1, 1};
+    known = 1;
+}
+
+// Cuts `region`, lexed from line 1, column 1 into `tokens` (closed by an
+// END_OF_FILE at its end), into segments at the split_top_level boundaries
+// and parses each one. A region without any declaration, such as a text of
+// only comments, still keeps its text in one segment, and so does an empty
+// one if it is the whole document (`whole`), which always has a segment.
+std::vector<std::unique_ptr<IncrementalDocument::Segment>> IncrementalDocument::make_segments(const std::string& region, std::vector<Token> tokens, bool whole) const {
+    std::vector<std::pair<size_t, size_t>> chunks = Parser::split_top_level(tokens);
+    if (chunks.empty() && (whole || !region.empty())) chunks.emplace_back(0, 0);
+
+    std::vector<std::unique_ptr<Segment>> segments;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        const size_t first = chunks[c].first;
+        const size_t from = c == 0 ? 0 : tokens[first].offset;
+        const size_t to = c + 1 < chunks.size() ? tokens[chunks[c + 1].first].offset : region.size();
+        const int line = c == 0 ? 1 : tokens[first].line;
+        const int column = c == 0 ? 1 : tokens[first].column;
+
+        auto segment = std::make_unique<Segment>();
+        segment->text = region.substr(from, to - from);
+        for (size_t i = first; i < chunks[c].second; i++) {
+            Token token = std::move(tokens[i]);
+            if (token.line == line) token.column -= column - 1;
+            token.line -= line - 1;
+            token.offset -= from;
+            segment->tokens.push_back(std::move(token));
+        }
+
+        for (char byte : segment->text) {
+            if (byte == '\n') {
+                segment->lines++;
+                segment->endColumn = 1;
+            } else if (!utf8_continuation(byte)) {
+                segment->endColumn++;
+            }
+        }
+        segment->tokens.push_back(Token{TokenType::END_OF_FILE, "", segment->lines + 1, segment->endColumn, segment->text.size()});
+        segment->statements = Parser(segment->tokens, lazyFunctions).parse();
+        segments.push_back(std::move(segment));
+    }
+    return segments;
+}
+
+IncrementalDocument::Position IncrementalDocument::start(size_t index) const {
+    for (; known <= index; known++) {
+        const Segment& previous = *parts[known - 1];
+        const Position& at = origins[known - 1];
+        origins[known] = Position{at.offset + previous.text.size(), at.line + previous.lines,
+                                  previous.lines ? previous.endColumn : at.column + previous.endColumn - 1};
+    }
+    return origins[index];
+}
+
+Token IncrementalDocument::absolute(size_t index, const Token& token) const {
+    Position at = start(index);
+    Token result = token;
+    result.offset += at.offset;
+    if (token.line == 1) result.column += at.column - 1;
+    result.line += at.line - 1;
+    return result;
+}
+
+// The segment holding byte `offset`, or the last one past the end.
+size_t IncrementalDocument::locate(size_t offset) const {
+    while (known < parts.size() && origins[known - 1].offset + parts[known - 1]->text.size() <= offset) {
+        start(known);
+    }
+    auto startsAfter = [](size_t at, const Position& position) { return at < position.offset; };
+    return std::upper_bound(origins.begin(), origins.begin() + known, offset, startsAfter) - origins.begin() - 1;
+}
+
+char IncrementalDocument::byte_at(size_t offset) const {
+    size_t index = locate(offset);
+    return parts[index]->text[offset - start(index).offset];
+}
+
+std::string IncrementalDocument::source() const {
+    std::string text;
+    text.reserve(length);
+    for (const auto& segment : parts) text += segment->text;
+    return text;
+}
+
+std::vector<Token> IncrementalDocument::tokens() const {
+    std::vector<Token> stream;
+    for (size_t i = 0; i < parts.size(); i++) {
+        const std::vector<Token>& own = parts[i]->tokens;
+        // Every segment closes with END_OF_FILE; only the last one is real.
+        size_t count = i + 1 < parts.size() ? own.size() - 1 : own.size();
+        for (size_t t = 0; t < count; t++) stream.push_back(absolute(i, own[t]));
+    }
+    return stream;
+}
+
+void IncrementalDocument::apply(const TextEdit& edit) {
+    if (edit.offset > length || edit.removed > length - edit.offset) {
+        throw std::out_of_range("Edit is past the end of the source");
+    }
+    // The rest of the text was validated when it arrived, so only the
+    // inserted bytes and the two cut points need checking.
+    auto boundary = [&](size_t offset) { return offset >= length || !utf8_continuation(byte_at(offset)); };
+    if (utf8_invalid_offset(edit.inserted.data(), edit.inserted.size()) != edit.inserted.size() ||
+        !boundary(edit.offset) || !boundary(edit.offset + edit.removed)) {
+        throw std::runtime_error("Edit would make the source invalid UTF-8");
+    }
+
+    // A segment start is a safe place to restart the lexer: nothing before it
+    // can reach past it. Start at the segment holding the byte before the
+    // edit, so a token the edit extends backwards is lexed again too.
+    size_t first = locate(edit.offset ? edit.offset - 1 : 0);
+    size_t next = std::max(first, locate(edit.offset + edit.removed ? edit.offset + edit.removed - 1 : 0)) + 1;
+    next = std::min(next, parts.size());
+
+    std::string region;
+    for (size_t i = first; i < next; i++) region += parts[i]->text;
+    region.replace(edit.offset - start(first).offset, edit.removed, edit.inserted);
+
+    // Lex the region plus a growing look-ahead of the segments after it,
+    // until a new token lines up with the first token of an old segment at
+    // bracket depth zero right after a statement: from there on the old
+    // segments are what a fresh lex and split would produce. An unclosed
+    // string or comment can swallow the rest of the text, so the look-ahead
+    // doubles rather than growing one segment at a time.
+    std::vector<Token> fresh;
+    size_t until;
+    while (true) {
+        size_t stop = parts.size();
+        for (size_t lookahead = 1;; lookahead *= 2) {
+            until = std::min(parts.size(), next + lookahead);
+            std::string working = region;
+            std::vector<size_t> bounds;
+            for (size_t i = next; i < until; i++) {
+                bounds.push_back(working.size());
+                working += parts[i]->text;
+            }
+
+            fresh.clear();
+            Lexer lexer(working, 0, 1, 1);
+            int depth = 0;
+            size_t bound = 0;
+            bool aligned = false;
+            while (true) {
+                Token token = lexer.getNextToken();
+                while (bound < bounds.size() && bounds[bound] < token.offset) bound++;
+                if (bound < bounds.size() && bounds[bound] == token.offset && depth == 0) {
+                    const Token& old = parts[next + bound]->tokens.front();
+                    // With nothing before it in the region, the token follows
+                    // the previous segment's last one, which ends a statement.
+                    bool follows = fresh.empty() ? first > 0 || token.offset == 0 : ends_statement(fresh.back().type);
+                    if (follows && old.type == token.type && old.value == token.value) {
+                        stop = next + bound;
+                        fresh.push_back(Token{TokenType::END_OF_FILE, "", token.line, token.column, token.offset});
+                        region = working.substr(0, token.offset);
+                        aligned = true;
+                        break;
+                    }
+                }
+                fresh.push_back(token);
+                if (token.type == TokenType::END_OF_FILE) break;
+                depth = bracket_depth(depth, token);
+            }
+            if (aligned) break;
+            if (until == parts.size()) {
+                region = std::move(working);
+                break;
+            }
+        }
+        until = stop;
+
+        // The region's first token must still be one split_top_level starts
+        // a segment at; if the edit changed it, the region joins the segment
+        // before. That one starts with an unchanged declaration keyword.
+        if (first == 0 || fresh.front().type == TokenType::END_OF_FILE || is_declaration(fresh.front().type)) break;
+        first--;
+        region = parts[first]->text + region;
+        next = until;
+    }
+
+    std::vector<std::unique_ptr<Segment>> replacement = make_segments(region, std::move(fresh), first == 0 && until == parts.size());
+
+    length = length - edit.removed + edit.inserted.size();
+    size_t common = std::min(replacement.size(), until - first);
+    std::move(replacement.begin(), replacement.begin() + common, parts.begin() + first);
+    if (replacement.size() > common) {
+        parts.insert(parts.begin() + first + common, std::make_move_iterator(replacement.begin() + common), std::make_move_iterator(replacement.end()));
+    } else {
+        parts.erase(parts.begin() + first + common, parts.begin() + until);
+    }
+    origins.resize(parts.size());
+    known = std::min(known, first + 1);
+}
+
+void IncrementalDocument::parse_function_body(size_t segment, FunctionDeclaration& function) {
+    Parser(parts[segment]->tokens, lazyFunctions).parse_function_body(function);
+}
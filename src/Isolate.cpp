@@ -0,0 +1,96 @@
+#include "Isolate.hpp"
+
+const std::string& StringTable::intern(std::string_view text) {
+    return *strings.emplace(text).first;
+}
+
+const std::string* StringTable::find(std::string_view text) const {
+    auto it = strings.find(std::string(text));
+    return it == strings.end() ? nullptr : &*it;
+}
+
+void Isolate::load(std::string source) {
+    auto unit = std::make_unique<Unit>();
+    unit->source = std::move(source);
+
+    Lexer lexer(unit->source);
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        unit->tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+
+    AllocatorScope scope(tracker);
+    TrackingAllocator::PhaseScope phase(tracker, Phase::PARSE);
+    unit->program = Parser(unit->tokens).parse();
+    bind(*unit);
+    units.push_back(std::move(unit));
+}
+
+void Isolate::bind(const Unit& unit) {
+    for (const auto& statement : unit.program) {
+        if (auto* function = dynamic_cast<const FunctionDeclaration*>(statement.get())) {
+            globals[&names.intern(function->name)] = function;
+        } else if (auto* variable = dynamic_cast<const VariableDeclaration*>(statement.get())) {
+            globals[&names.intern(variable->name)] = variable;
+        }
+    }
+}
+
+// --- Snapshots ---
+// Units are concatenated into one token stream with a single END_OF_FILE, so
+// the image splits and reloads as one unit. Token offsets still refer to each
+// unit's own source.
+void Isolate::save_snapshot(const std::string& path) const {
+    std::vector<Token> tokens;
+    for (const auto& unit : units) {
+        std::vector<Token> decoded = unit->image ? unit->image->load_tokens() : std::vector<Token>();
+        for (const auto& token : unit->image ? decoded : unit->tokens) {
+            if (token.type != TokenType::END_OF_FILE) tokens.push_back(token);
+        }
+    }
+
+    Token end;
+    end.type = TokenType::END_OF_FILE;
+    end.line = tokens.empty() ? 1 : tokens.back().line;
+    end.column = 0;
+    tokens.push_back(end);
+    write_snapshot(path, tokens);
+}
+
+void Isolate::load_snapshot(const std::string& path) {
+    AllocatorScope scope(tracker);
+    TrackingAllocator::PhaseScope phase(tracker, Phase::PARSE);
+    auto unit = std::make_unique<Unit>();
+    unit->image = std::make_unique<Snapshot>(path);
+    unit->tokens = unit->image->load_tokens(false);
+    unit->program = unit->image->load_program(unit->tokens);
+    bind(*unit);
+    units.push_back(std::move(unit));
+}
+
+// Finds the unit whose tokens the body range refers to.
+void Isolate::parse_function_body(FunctionDeclaration& function) {
+    if (!function.isLazy()) return;
+
+    AllocatorScope scope(tracker);
+    TrackingAllocator::PhaseScope phase(tracker, Phase::PARSE);
+    for (const auto& unit : units) {
+        for (const auto& statement : unit->program) {
+            if (statement.get() == &function) {
+                if (unit->image) unit->image->load_token_range(unit->tokens, function.bodyBegin, function.bodyEnd);
+                Parser(unit->tokens, true).parse_function_body(function);
+                return;
+            }
+        }
+    }
+}
+
+// Looks up without interning, so a miss does not grow the table.
+const Statement* Isolate::global(std::string_view name) const {
+    const std::string* interned = names.find(name);
+    if (!interned) return nullptr;
+
+    auto it = globals.find(interned);
+    return it == globals.end() ? nullptr : it->second;
+}
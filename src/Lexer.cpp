@@ -1,86 +1,254 @@
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <cctype>
+#include <charconv>
 #include <vector>
+#include <unistd.h>
 #include "../include/Lexer.hpp"
+#include "../include/Allocator.hpp"
+#include "../include/Dump.hpp"
+#include "../include/ModuleLoader.hpp"
+#include "../include/Stats.hpp"
+#include "../include/Parser.hpp"
+#include "../include/Snapshot.hpp"
+#include "../include/passes/Optimizer.hpp"
+#include "../include/passes/TypeInference.hpp"
 
+static void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--stats | --stats=json] [--passes=inline,cse,licm,dce] [--passes-report] [--types] [--dump=text|tokens|ast] [--memory-budget=BYTES] [--alloc-report] [--snapshot=IMAGE] [--modules] filename\n"
+              << "       " << program << " [options] --from-snapshot=IMAGE\n"
+              << "  --memory-budget caps AST node storage only; tokens and strings are not counted.\n"
+              << "  --from-snapshot reads the tokens and program from a snapshot image instead of a source file.\n";
+}
 
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " filename\n";
+    bool stats = false;
+    bool statsJson = false;
+    std::string passes; // empty until --passes is given
+    bool passesReport = false;
+    bool types = false;
+    std::string snapshot;
+    std::string fromSnapshot;
+    bool modules = false;
+    std::string dump = "text";
+    size_t memoryBudget = SIZE_MAX;
+    bool allocReport = false;
+    std::string filename;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--stats") {
+            stats = true;
+        } else if (arg == "--stats=json") {
+            stats = statsJson = true;
+        } else if (arg.rfind("--passes=", 0) == 0) {
+            passes = "," + arg.substr(9) + ",";
+        } else if (arg == "--passes-report") {
+            passesReport = true;
+        } else if (arg == "--types") {
+            types = true;
+        } else if (arg == "--dump=text" || arg == "--dump=tokens" || arg == "--dump=ast") {
+            dump = arg.substr(7);
+        } else if (arg.rfind("--memory-budget=", 0) == 0) {
+            const char* first = arg.c_str() + 16;
+            const char* last = arg.c_str() + arg.size();
+            auto [end, error] = std::from_chars(first, last, memoryBudget);
+            if (first == last || error != std::errc() || end != last) {
+                std::cerr << "Invalid --memory-budget: '" << first << "'\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--alloc-report") {
+            allocReport = true;
+        } else if (arg.rfind("--snapshot=", 0) == 0) {
+            snapshot = arg.substr(11);
+        } else if (arg.rfind("--from-snapshot=", 0) == 0) {
+            fromSnapshot = arg.substr(16);
+        } else if (arg == "--modules") {
+            modules = true;
+        } else {
+            filename = arg;
+        }
+    }
+
+    if (filename.empty() == fromSnapshot.empty() || (modules && !fromSnapshot.empty())) {
+        print_usage(argv[0]);
         return 1;
     }
 
-    std::string filename = argv[1];
+    // --dump=ast shows the tree as parsed unless passes are asked for.
+    if (passes.empty()) passes = dump == "ast" ? "," : ",inline,cse,licm,dce,";
 
-    
-    std::ifstream file(filename, std::ios::in | std::ios::binary);
-    if (!file) {
-        std::cerr << "Could not open file: " << filename << "\n";
-        return 1;
-    };
-    
-    file.seekg(0, std::ios::end);
-    size_t size = file.tellg();
-    file.seekg(0);
+    // --modules loads the file and everything it imports, and lists the
+    // modules instead of any other output.
+    if (modules) {
+        std::vector<std::shared_ptr<const Module>> graph;
+        try {
+            graph = ModuleLoader().load(filename);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
 
-    std::string contents(size, '\0');
-    file.read(&contents[0], size);
+        int status = 0;
+        for (const auto& module : graph) {
+            if (!module->error.empty()) {
+                std::cerr << module->path << ": " << module->error << "\n";
+                status = 1;
+                continue;
+            }
+            std::cout << module->path << ": " << module->program.size() << " declarations, " << module->imports.size()
+                      << " imports\n";
+        }
+        return status;
+    }
 
+#ifndef AGSCRIPT_STATS
+    if (stats) {
+        std::cerr << "--stats is not available: rebuild with -DAGSCRIPT_STATS\n";
+        stats = false;
+    }
+#endif
     
+    // --from-snapshot starts from an image's tokens and program instead of
+    // lexing and parsing a source file.
+    std::unique_ptr<Snapshot> image;
+    if (!fromSnapshot.empty()) {
+        filename = fromSnapshot;
+        STATS_PHASE(Phase::READ);
+        try {
+            image = std::make_unique<Snapshot>(fromSnapshot);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
 
-    Lexer lexer(contents);
-    Token token;
-    do {
-        token = lexer.getNextToken();
-        std::cout << "Token: ";
-        switch (token.type) {
-            case TokenType::IDENTIFIER: std::cout << "IDENTIFIER"; break;
-            case TokenType::KEYWORD: std::cout << "KEYWORD"; break;
-            case TokenType::INT_LITERAL: std::cout << "INT_LITERAL"; break;
-            case TokenType::FLOAT_LITERAL: std::cout << "FLOAT_LITERAL"; break;
-            case TokenType::STRING_LITERAL: std::cout << "STRING_LITERAL"; break;
-            case TokenType::BOOLEAN_LITERAL: std::cout << "BOOLEAN_LITERAL"; break;
-            case TokenType::NULL_LITERAL: std::cout << "NULL_LITERAL"; break;
-            case TokenType::ADD: std::cout << "PLUS"; break;
-            case TokenType::SUBTRACT: std::cout << "MINUS"; break;
-            case TokenType::MULTIPLY: std::cout << "MULTIPLY"; break;
-            case TokenType::DIVIDE: std::cout << "DIVIDE"; break;
-            case TokenType::ASSIGN: std::cout << "ASSIGN"; break;
-            case TokenType::EQUAL: std::cout << "EQUAL"; break;
-            case TokenType::NOT_EQUAL: std::cout << "NOT_EQUAL"; break;
-            case TokenType::LESS_THAN: std::cout << "LESS_THAN"; break;
-            case TokenType::LESS_THAN_OR_EQUAL: std::cout << "LESS_EQUAL"; break;
-            case TokenType::GREATER_THAN: std::cout << "GREATER_THAN"; break;
-            case TokenType::GREATER_THAN_OR_EQUAL: std::cout << "GREATER_EQUAL"; break;
-            case TokenType::AND: std::cout << "AND"; break;
-            case TokenType::OR: std::cout << "OR"; break;
-            case TokenType::NOT: std::cout << "NOT"; break;
-            case TokenType::LEFT_PARENTHESIS: std::cout << "LEFT_PAREN"; break;
-            case TokenType::RIGHT_PARENTHESIS: std::cout << "RIGHT_PAREN"; break;
-            case TokenType::LEFT_BRACKET: std::cout << "LEFT_BRACKET"; break;
-            case TokenType::RIGHT_BRACKET: std::cout << "RIGHT_BRACKET"; break;
-            case TokenType::LEFT_BRACE: std::cout << "LEFT_BRACE"; break;
-            case TokenType::RIGHT_BRACE: std::cout << "RIGHT_BRACE"; break;
-            case TokenType::COMMA: std::cout << "COMMA"; break;
-            case TokenType::DOT: std::cout << "DOT"; break;
-            case TokenType::SEMI_COLON: std::cout << "SEMI_COLON"; break;
-            case TokenType::NEW_LINE: std::cout << "NEW_LINE"; break;
-            case TokenType::COMMENT: std::cout << "COMMENT"; break;
-            case TokenType::END_OF_FILE: std::cout << "END_OF_FILE"; break;
-            case TokenType::UNKNOWN: std::cout << "UNKNOWN"; break;
-            case TokenType::FUNCTION: std::cout << "FUNCTION"; break;
-            case TokenType::IF: std::cout << "IF"; break;
-            case TokenType::RETURN: std::cout << "RETURN"; break;
-            case TokenType::ELSE: std::cout << "ELSE"; break;
-            case TokenType::FOR: std::cout << "FOR"; break;
-            case TokenType::WHILE: std::cout << "WHILE"; break;
-            case TokenType::IN: std::cout << "IN"; break;
+    std::string contents;
+    if (!image) {
+        STATS_PHASE(Phase::READ);
+        std::ifstream file(filename, std::ios::in | std::ios::binary);
+        if (!file) {
+            std::cerr << "Could not open file: " << filename << "\n";
+            return 1;
         };
         
-        std::cout << ", Value: '" << token.value << "', Line: " << token.line << ", Col: " << token.column << "\n";
-    } while (token.type != TokenType::END_OF_FILE);
+        file.seekg(0, std::ios::end);
+        size_t size = file.tellg();
+        file.seekg(0);
 
+        contents.resize(size);
+        file.read(&contents[0], size);
+        STATS_ADD(Counter::BYTES, size);
+    }
+
+    std::vector<Token> tokens;
+    {
+        STATS_PHASE(Phase::LEX);
+        try {
+            if (image) {
+                tokens = image->load_tokens();
+            } else {
+                Lexer lexer(contents);
+                Token token;
+                do {
+                    token = lexer.getNextToken();
+                    tokens.push_back(token);
+                } while (token.type != TokenType::END_OF_FILE);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << filename << ": " << e.what() << "\n";
+            return 1;
+        }
+        STATS_ADD(Counter::TOKENS, tokens.size());
+    }
+
+    // --snapshot writes the prelude image instead of any other output.
+    if (!snapshot.empty()) {
+        try {
+            write_snapshot(snapshot, tokens);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // --types replaces the token dump.
+    OutputBuffer out(STDOUT_FILENO);
+    if (!types && dump == "text") {
+        dump_tokens_text(tokens, out);
+    } else if (!types && dump == "tokens") {
+        dump_tokens_binary(tokens, out);
+    }
+
+    if (stats || passesReport || types || dump == "ast" || allocReport || memoryBudget != SIZE_MAX) {
+        // AST nodes live in one arena for the rest of the run; the tracker
+        // counts their storage per phase and enforces --memory-budget.
+        ArenaAllocator arena;
+        TrackingAllocator tracker(arena, memoryBudget);
+        AllocatorScope scope(tracker);
+
+        std::vector<StmtPtr> program;
+        try {
+            {
+                STATS_PHASE(Phase::PARSE);
+                TrackingAllocator::PhaseScope phase(tracker, Phase::PARSE);
+                if (image) {
+                    // The passes and dumps want every body, so parse them now.
+                    program = image->load_program(tokens);
+                    Parser parser(tokens, true);
+                    for (auto& statement : program) {
+                        auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+                        if (!function) continue;
+                        try {
+                            parser.parse_function_body(*function);
+                        } catch (const MemoryBudgetExceeded&) {
+                            throw;
+                        } catch (const std::runtime_error&) {
+                            // Reported by the parser; the body stays lazy.
+                        }
+                    }
+                } else {
+                    Parser parser(tokens);
+                    program = parser.parse();
+                }
+            }
+            auto enabled = [&](const char* pass) { return passes.find(std::string(",") + pass + ",") != std::string::npos; };
+            OptimizerOptions options;
+            options.inlining = enabled("inline");
+            options.cse = enabled("cse");
+            options.licm = enabled("licm");
+            options.deadCode = enabled("dce");
+            options.report = passesReport ? &std::cerr : nullptr;
+            TrackingAllocator::PhaseScope phase(tracker, Phase::PASSES);
+            optimize(program, options);
+        } catch (const MemoryBudgetExceeded& e) {
+            std::cerr << filename << ": " << e.what() << "\n";
+            return 1;
+        }
+
+        if (types) {
+            TypeInference().run(program);
+            dump_types(program, std::cout);
+        } else if (dump == "ast") {
+            dump_ast_binary(program, out);
+        }
+
+        std::cout.flush();
+#ifdef AGSCRIPT_STATS
+        if (stats) Stats::report(std::cerr, statsJson);
+#endif
+        if (allocReport) tracker.report(std::cerr);
+    }
+
+    try {
+        out.flush();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
     return 0;
 }
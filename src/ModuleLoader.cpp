@@ -0,0 +1,159 @@
+#include "ModuleLoader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+static std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open file: " + path);
+    }
+
+    file.seekg(0, std::ios::end);
+    size_t size = file.tellg();
+    file.seekg(0);
+
+    std::string contents(size, '\0');
+    file.read(&contents[0], size);
+    return contents;
+}
+
+// Import paths are relative to the importing file; ".ajg" is implied.
+static std::string resolve_import(const std::string& importer, const std::string& path) {
+    fs::path target = fs::path(importer).parent_path() / path;
+    if (!target.has_extension()) target += ".ajg";
+    return fs::weakly_canonical(target).string();
+}
+
+// The imports are the top-level ImportDeclarations: chunks that start with
+// IMPORT and continue as import_decl does. An `import` inside a function body
+// is a syntax error for the parser to report, not an edge.
+static std::vector<std::string> find_imports(const std::string& importer, const std::vector<Token>& tokens) {
+    std::vector<std::string> imports;
+    for (const auto& chunk : Parser::split_top_level(tokens, 0, tokens.size())) {
+        size_t i = chunk.first;
+        if (chunk.second - i >= 3 && tokens[i].type == TokenType::IMPORT && tokens[i + 1].type == TokenType::STRING_LITERAL &&
+            tokens[i + 2].type == TokenType::SEMI_COLON) {
+            imports.push_back(resolve_import(importer, tokens[i + 1].value));
+        }
+    }
+    return imports;
+}
+
+ModuleLoader::ModuleLoader(unsigned threads)
+    : threads(threads ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+std::vector<std::shared_ptr<const Module>> ModuleLoader::load(const std::string& path) {
+    std::unordered_map<std::string, Pending> graph;
+    std::vector<std::string> stack;
+    std::vector<std::string> order;
+    discover(fs::weakly_canonical(path).string(), graph, stack, order);
+
+    std::vector<Module*> stale;
+    for (const auto& name : order) {
+        Pending& pending = graph[name];
+        if (pending.changed) {
+            stale.push_back(pending.module.get());
+            cache[name] = std::move(pending.module);
+        }
+    }
+
+    compile(stale);
+
+    std::vector<std::shared_ptr<const Module>> modules;
+    for (const auto& name : order) modules.push_back(cache[name]);
+    return modules;
+}
+
+void ModuleLoader::discover(const std::string& path, std::unordered_map<std::string, Pending>& graph,
+                            std::vector<std::string>& stack, std::vector<std::string>& order) {
+    if (std::find(stack.begin(), stack.end(), path) != stack.end()) {
+        throw std::runtime_error("Import cycle through: " + path);
+    }
+    if (graph.count(path)) return;
+
+    std::error_code ec;
+    long long modified = fs::last_write_time(path, ec).time_since_epoch().count();
+    if (ec) {
+        throw std::runtime_error("Could not open file: " + path);
+    }
+
+    auto cached = cache.find(path);
+    Pending pending{nullptr, false};
+    const Module* module = nullptr;
+
+    if (cached != cache.end() && cached->second->modified == modified) {
+        module = cached->second.get();
+    } else {
+        std::string source = read_file(path);
+        size_t hash = std::hash<std::string>{}(source);
+
+        if (cached != cache.end() && cached->second->hash == hash) {
+            // Touched but not edited.
+            cached->second->modified = modified;
+            module = cached->second.get();
+        } else {
+            pending.module = std::make_shared<Module>();
+            pending.changed = true;
+            Module& fresh = *pending.module;
+            fresh.path = path;
+            fresh.source = std::move(source);
+            fresh.hash = hash;
+            fresh.modified = modified;
+
+            try {
+                Lexer lexer(fresh.source);
+                Token token;
+                do {
+                    token = lexer.getNextToken();
+                    fresh.tokens.push_back(token);
+                } while (token.type != TokenType::END_OF_FILE);
+                fresh.imports = find_imports(path, fresh.tokens);
+            } catch (const std::exception& e) {
+                fresh.error = e.what();
+                fresh.tokens.clear();
+            }
+            module = &fresh;
+        }
+    }
+
+    std::vector<std::string> imports = module->imports;
+    graph.emplace(path, std::move(pending));
+
+    stack.push_back(path);
+    for (const auto& import : imports) {
+        discover(import, graph, stack, order);
+    }
+    stack.pop_back();
+
+    order.push_back(path);
+}
+
+// Parsing a module does not look at its imports, so every stale module can
+// be compiled at once instead of level by level.
+void ModuleLoader::compile(std::vector<Module*>& modules) {
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < modules.size(); i = next++) {
+            Module& module = *modules[i];
+            if (!module.error.empty()) continue;
+            try {
+                module.program = Parser(module.tokens).parse();
+            } catch (const std::exception& e) {
+                module.program.clear();
+                module.error = e.what();
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    unsigned count = std::min<size_t>(threads, modules.size());
+    for (unsigned i = 1; i < count; i++) pool.emplace_back(worker);
+    worker();
+    for (auto& thread : pool) thread.join();
+}
@@ -0,0 +1,50 @@
+// Parser::parse_parallel lives apart from the rest of the parser so that
+// only its users link the worker pool.
+#include "Parser.hpp"
+#include <algorithm>
+#include <thread>
+#include "ParallelFor.hpp"
+
+ParallelProgram Parser::parse_parallel(const std::vector<Token>& tokens, WorkerPool& pool, bool lazyFunctions) {
+    const size_t threads = pool.size() + 1;
+
+    // Merge neighbouring declarations so each task is big enough to outweigh
+    // the scheduling cost; a few tasks per thread keeps them balanced.
+    const size_t minTokens = std::max<size_t>(256, tokens.size() / (threads * 4));
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (const auto& range : split_top_level(tokens)) {
+        if (!chunks.empty() && chunks.back().second - chunks.back().first < minTokens) {
+            chunks.back().second = range.second;
+        } else {
+            chunks.push_back(range);
+        }
+    }
+
+    ParallelProgram program;
+    if (chunks.size() <= 1) {
+        program.statements = Parser(tokens, lazyFunctions).parse();
+        return program;
+    }
+
+    // arenas[0] serves the calling thread and arenas[i + 1] worker i. Chunks
+    // on one thread run one after another, so no arena is shared.
+    program.upstream = std::make_unique<SynchronizedAllocator>(current_allocator());
+    for (size_t i = 0; i < threads; i++) {
+        program.arenas.push_back(std::make_unique<ArenaAllocator>(*program.upstream));
+    }
+
+    std::vector<std::vector<StmtPtr>> results(chunks.size());
+    const std::thread::id caller = std::this_thread::get_id();
+    parallel_chunks(pool, chunks.size(), [&](size_t, size_t begin, size_t end) {
+        size_t arena = std::this_thread::get_id() == caller ? 0 : WorkerPool::current_worker() + 1;
+        AllocatorScope scope(*program.arenas[arena]);
+        for (size_t i = begin; i < end; i++) {
+            results[i] = Parser(tokens, chunks[i].first, chunks[i].second, lazyFunctions).parse();
+        }
+    });
+
+    for (auto& statements : results) {
+        for (auto& statement : statements) program.statements.push_back(std::move(statement));
+    }
+    return program;
+}
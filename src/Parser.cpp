@@ -1,6 +1,8 @@
 #include "Parser.hpp"
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <unordered_map>
 #include "include/ast/Expression.hpp"
 #include "include/ast/Statement.hpp"
 
@@ -9,13 +11,80 @@
 // for each construct like FunctionDeclStmt, VariableDeclStmt, BinaryExpr, etc.
 
 // --- Parser constructor ---
-Parser::Parser(const std::vector<Token>& tokens) : tokens(tokens), current(0) {}
+Parser::Parser(const std::vector<Token>& tokens, bool lazyFunctions)
+    : tokens(tokens), current(0), end(tokens.size()), lazyFunctions(lazyFunctions) {}
+
+Parser::Parser(const std::vector<Token>& tokens, size_t begin, size_t end, bool lazyFunctions)
+    : tokens(tokens), current(begin), end(std::min(end, tokens.size())), lazyFunctions(lazyFunctions) {}
 
 // --- Parse entry point ---
 std::vector<StmtPtr> Parser::parse() {
     return program();
 }
 
+// --- Deferred function bodies ---
+// Parses a body skipped in lazy mode. Cheap no-op once the body exists, so
+// callers can invoke it unconditionally on every call.
+void Parser::parse_function_body(FunctionDeclaration& function) {
+    if (!function.isLazy()) return;
+
+    size_t saved = current;
+    current = function.bodyBegin;
+    try {
+        function.body = block();
+    } catch (...) {
+        current = saved;
+        throw;
+    }
+    current = saved;
+}
+
+// --- Parallel parsing ---
+// A declaration boundary is a FUNCTION, LET, IMPORT or MEMO token outside any
+// bracket pair that starts a statement, i.e. follows a ';', a '}' or the start
+// of the range; the FUNCTION after a MEMO belongs to the MEMO's chunk, and so
+// does the unbraced body in `if (c) let y = 1;` to its if statement.
+// Anything else at the top level stays with the declaration before it.
+std::vector<std::pair<size_t, size_t>> Parser::split_top_level(const std::vector<Token>& tokens, size_t begin, size_t end) {
+    std::vector<std::pair<size_t, size_t>> chunks;
+    end = std::min(end, tokens.size());
+    size_t start = begin;
+    int depth = 0;
+
+    for (size_t i = begin; i < end; i++) {
+        switch (tokens[i].type) {
+            case TokenType::LEFT_BRACE:
+            case TokenType::LEFT_BRACKET:
+            case TokenType::LEFT_PARENTHESIS:
+                depth++;
+                break;
+            case TokenType::RIGHT_BRACE:
+            case TokenType::RIGHT_BRACKET:
+            case TokenType::RIGHT_PARENTHESIS:
+                if (depth > 0) depth--;
+                break;
+            case TokenType::FUNCTION:
+            case TokenType::LET:
+            case TokenType::IMPORT:
+            case TokenType::MEMO:
+                if (depth == 0 && i > start
+                    && (tokens[i - 1].type == TokenType::SEMI_COLON || tokens[i - 1].type == TokenType::RIGHT_BRACE)) {
+                    chunks.emplace_back(start, i);
+                    start = i;
+                }
+                break;
+            case TokenType::END_OF_FILE:
+                if (i > start) chunks.emplace_back(start, i);
+                return chunks;
+            default:
+                break;
+        }
+    }
+
+    if (end > start) chunks.emplace_back(start, end);
+    return chunks;
+}
+
 // --- Helpers ---
 bool Parser::match(std::initializer_list<TokenType> types) {
     for (auto type : types) {
@@ -38,7 +107,7 @@ Token Parser::advance() {
 }
 
 bool Parser::isAtEnd() const {
-    return peek().type == TokenType::END_OF_FILE;
+    return current >= end || peek().type == TokenType::END_OF_FILE;
 }
 
 Token Parser::peek() const {
@@ -62,9 +131,12 @@ void Parser::synchronize() {
         switch (peek().type) {
             case TokenType::FUNCTION:
             case TokenType::LET:
+            case TokenType::IMPORT:
+            case TokenType::MEMO:
             case TokenType::IF:
             case TokenType::WHILE:
             case TokenType::FOR:
+            case TokenType::PARALLEL:
             case TokenType::RETURN:
                 return;
             default:
@@ -73,6 +145,29 @@ void Parser::synchronize() {
     }
 }
 
+// Brace-matches the block starting at the current token without building
+// any nodes. Returns the index of the opening brace.
+size_t Parser::skip_block() {
+    if (!check(TokenType::LEFT_BRACE)) {
+        error(peek(), "Expected '{' to start block");
+        throw std::runtime_error("Parse error");
+    }
+    size_t start = current;
+
+    int depth = 0;
+    do {
+        if (isAtEnd()) {
+            error(peek(), "Expected '}' after block");
+            throw std::runtime_error("Parse error");
+        }
+        TokenType type = advance().type;
+        if (type == TokenType::LEFT_BRACE) depth++;
+        else if (type == TokenType::RIGHT_BRACE) depth--;
+    } while (depth > 0);
+
+    return start;
+}
+
 // --- Grammar rules ---
 
 // program ::= { declaration } ;
@@ -81,6 +176,8 @@ std::vector<StmtPtr> Parser::program() {
     while (!isAtEnd()) {
         try {
             declarations.push_back(declaration());
+        } catch (const MemoryBudgetExceeded&) {
+            throw; // not a syntax error; recovering would only fail again
         } catch (...) {
             synchronize();
         }
@@ -88,10 +185,12 @@ std::vector<StmtPtr> Parser::program() {
     return declarations;
 }
 
-// declaration ::= function_decl | variable_decl ;
+// declaration ::= function_decl | variable_decl | import_decl ;
 StmtPtr Parser::declaration() {
     if (match({TokenType::FUNCTION})) return function_decl();
+    if (match({TokenType::MEMO})) return memo_function_decl();
     if (match({TokenType::LET})) return variable_decl();
+    if (match({TokenType::IMPORT})) return import_decl();
 
     // Fall back to statement
     return statement();
@@ -111,20 +210,15 @@ StmtPtr Parser::function_decl() {
         throw std::runtime_error("Parse error");
     }
 
-    std::vector<ExprPtr> params;
+    std::vector<std::string> params;
     if (!check(TokenType::RIGHT_PARENTHESIS)) {
-        // parse parameters as identifiers wrapped in expressions or a special Param type
-        // For simplicity, treat as variable expressions here:
         do {
             if (!check(TokenType::IDENTIFIER)) {
                 error(peek(), "Expected parameter name");
                 throw std::runtime_error("Parse error");
             }
             Token paramName = advance();
-            // You might want a specific Param node, but we'll store as VariableExpression for now
-            // TODO: create Param node if needed
-            // Just push some Expression wrapping paramName.lexeme or so.
-            // For now, leave empty or a placeholder.
+            params.push_back(paramName.value);
         } while (match({TokenType::COMMA}));
     }
 
@@ -133,10 +227,30 @@ StmtPtr Parser::function_decl() {
         throw std::runtime_error("Parse error");
     }
 
-    StmtPtr body = block();
+    STATS_NODE(FUNCTION);
+    auto function = std::make_unique<FunctionDeclaration>(name.value, std::move(params), nullptr);
+    function->line = name.line;
+
+    if (lazyFunctions) {
+        function->bodyBegin = skip_block();
+        function->bodyEnd = current;
+        return function;
+    }
+
+    function->body = block();
+    return function;
+}
+
+// memo_function_decl ::= MEMO function_decl ;
+StmtPtr Parser::memo_function_decl() {
+    if (!match({TokenType::FUNCTION})) {
+        error(peek(), "Expected 'function' after 'memo'");
+        throw std::runtime_error("Parse error");
+    }
 
-    // TODO: return new FunctionDeclaration node with name, params, and body
-    return nullptr; // placeholder
+    StmtPtr function = function_decl();
+    static_cast<FunctionDeclaration&>(*function).memoize = true;
+    return function;
 }
 
 // variable_decl ::= LET IDENTIFIER [ ASSIGN expression ] SEMI_COLON ;
@@ -157,8 +271,25 @@ StmtPtr Parser::variable_decl() {
         throw std::runtime_error("Parse error");
     }
 
-    // TODO: return new VariableDeclaration node with name and initializer
-    return nullptr; // placeholder
+    STATS_NODE(VARIABLE_DECLARATION);
+    return std::make_unique<VariableDeclaration>(name.value, std::move(initializer));
+}
+
+// import_decl ::= IMPORT STRING_LITERAL SEMI_COLON ;
+StmtPtr Parser::import_decl() {
+    if (!check(TokenType::STRING_LITERAL)) {
+        error(peek(), "Expected module path after 'import'");
+        throw std::runtime_error("Parse error");
+    }
+    Token path = advance();
+
+    if (!match({TokenType::SEMI_COLON})) {
+        error(peek(), "Expected ';' after import");
+        throw std::runtime_error("Parse error");
+    }
+
+    STATS_NODE(IMPORT);
+    return std::make_unique<ImportDeclaration>(path.value);
 }
 
 // block ::= LEFT_BRACE { statement } RIGHT_BRACE ;
@@ -178,22 +309,22 @@ StmtPtr Parser::block() {
         throw std::runtime_error("Parse error");
     }
 
-    // TODO: return BlockStatement node containing statements
-    return nullptr; // placeholder
+    STATS_NODE(BLOCK);
+    return std::make_unique<BlockStatement>(std::move(statements));
 }
 
-// statement ::= expression_statement | if_statement | while_statement | return_statement | for_statement | variable_decl | block | SEMI_COLON ;
+// statement ::= expression_statement | if_statement | while_statement | return_statement | for_statement | parallel_for_statement | variable_decl | block | SEMI_COLON ;
 StmtPtr Parser::statement() {
     if (match({TokenType::IF})) return if_statement();
     if (match({TokenType::WHILE})) return while_statement();
     if (match({TokenType::RETURN})) return return_statement();
     if (match({TokenType::FOR})) return for_statement();
+    if (match({TokenType::PARALLEL})) return parallel_for_statement();
     if (match({TokenType::LET})) return variable_decl();
-    if (match({TokenType::LEFT_BRACE})) return block();
+    if (check(TokenType::LEFT_BRACE)) return block();
 
     if (match({TokenType::SEMI_COLON})) {
-        // Empty statement
-        // TODO: return EmptyStatement node or nullptr
+        // Empty statement: no node; consumers skip nullptr entries
         return nullptr;
     }
 
@@ -207,8 +338,8 @@ StmtPtr Parser::expression_statement() {
         error(peek(), "Expected ';' after expression");
         throw std::runtime_error("Parse error");
     }
-    // TODO: return ExpressionStatement node wrapping expr
-    return nullptr; // placeholder
+    STATS_NODE(EXPRESSION_STATEMENT);
+    return std::make_unique<ExpressionStatement>(std::move(expr));
 }
 
 // if_statement ::= IF LEFT_PARENTHESIS expression RIGHT_PARENTHESIS statement [ ELSE statement ] ;
@@ -231,8 +362,8 @@ StmtPtr Parser::if_statement() {
         elseBranch = statement();
     }
 
-    // TODO: return IfStatement node with condition, thenBranch, elseBranch
-    return nullptr; // placeholder
+    STATS_NODE(IF);
+    return std::make_unique<IfStatement>(std::move(condition), std::move(thenBranch), std::move(elseBranch));
 }
 
 // while_statement ::= WHILE LEFT_PARENTHESIS expression RIGHT_PARENTHESIS statement ;
@@ -251,8 +382,8 @@ StmtPtr Parser::while_statement() {
 
     StmtPtr body = statement();
 
-    // TODO: return WhileStatement node with condition and body
-    return nullptr; // placeholder
+    STATS_NODE(WHILE);
+    return std::make_unique<WhileStatement>(std::move(condition), std::move(body));
 }
 
 // for_statement ::= FOR LEFT_PARENTHESIS [ variable_decl | expression_statement | SEMI_COLON ]
@@ -296,8 +427,70 @@ StmtPtr Parser::for_statement() {
 
     StmtPtr body = statement();
 
-    // TODO: return ForStatement node with initializer, condition, increment, and body
-    return nullptr; // placeholder
+    STATS_NODE(FOR);
+    return std::make_unique<ForStatement>(std::move(initializer), std::move(condition), std::move(increment), std::move(body));
+}
+
+// parallel_for_statement ::= PARALLEL FOR IDENTIFIER IN expression
+//                            [ REDUCE IDENTIFIER LEFT_PARENTHESIS IDENTIFIER RIGHT_PARENTHESIS ]
+//                            COLON statement ;
+StmtPtr Parser::parallel_for_statement() {
+    if (!match({TokenType::FOR})) {
+        error(peek(), "Expected 'for' after 'parallel'");
+        throw std::runtime_error("Parse error");
+    }
+
+    if (!match({TokenType::IDENTIFIER})) {
+        error(peek(), "Expected loop variable");
+        throw std::runtime_error("Parse error");
+    }
+    std::string variable = previous().value;
+
+    if (!match({TokenType::IN})) {
+        error(peek(), "Expected 'in' after loop variable");
+        throw std::runtime_error("Parse error");
+    }
+
+    ExprPtr iterable = expression();
+
+    Reduction reduction = Reduction::NONE;
+    std::string target;
+    if (match({TokenType::REDUCE})) {
+        static const std::unordered_map<std::string, Reduction> reductions = {
+            {"sum", Reduction::SUM},
+            {"min", Reduction::MIN},
+            {"max", Reduction::MAX},
+            {"append", Reduction::APPEND},
+        };
+
+        auto it = match({TokenType::IDENTIFIER}) ? reductions.find(previous().value) : reductions.end();
+        if (it == reductions.end()) {
+            error(previous(), "Expected sum, min, max or append after 'reduce'");
+            throw std::runtime_error("Parse error");
+        }
+        reduction = it->second;
+
+        if (!match({TokenType::LEFT_PARENTHESIS}) || !match({TokenType::IDENTIFIER})) {
+            error(peek(), "Expected '(' and a variable after reduction");
+            throw std::runtime_error("Parse error");
+        }
+        target = previous().value;
+
+        if (!match({TokenType::RIGHT_PARENTHESIS})) {
+            error(peek(), "Expected ')' after reduction variable");
+            throw std::runtime_error("Parse error");
+        }
+    }
+
+    if (!match({TokenType::COLON})) {
+        error(peek(), "Expected ':' before parallel loop body");
+        throw std::runtime_error("Parse error");
+    }
+
+    StmtPtr body = statement();
+
+    STATS_NODE(PARALLEL_FOR);
+    return std::make_unique<ParallelForStatement>(std::move(variable), std::move(iterable), reduction, std::move(target), std::move(body));
 }
 
 // return_statement ::= RETURN [ expression ] SEMI_COLON ;
@@ -311,8 +504,8 @@ StmtPtr Parser::return_statement() {
         throw std::runtime_error("Parse error");
     }
 
-    // TODO: return ReturnStatement node with value
-    return nullptr; // placeholder
+    STATS_NODE(RETURN);
+    return std::make_unique<ReturnStatement>(std::move(value));
 }
 
 // expression ::= assignment ;
@@ -330,8 +523,10 @@ ExprPtr Parser::assignment() {
         ExprPtr value = assignment();
 
         // Left side must be an identifier
-        // TODO: add code to check expr is VariableExpression and create Assignment node
-        // For now, just throw
+        if (auto* target = dynamic_cast<VariableExpression*>(expr.get())) {
+            STATS_NODE(ASSIGN);
+            return std::make_unique<AssignExpression>(std::move(target->name), std::move(value));
+        }
         error(equals, "Invalid assignment target.");
         throw std::runtime_error("Parse error");
     }
@@ -346,7 +541,8 @@ ExprPtr Parser::logical_or() {
     while (match({TokenType::OR})) {
         Token op = previous();
         ExprPtr right = logical_and();
-        // TODO: return BinaryExpression node with OR op
+        STATS_NODE(BINARY);
+        expr = std::make_unique<BinaryExpression>(op.type, std::move(expr), std::move(right));
     }
 
     return expr;
@@ -359,7 +555,8 @@ ExprPtr Parser::logical_and() {
     while (match({TokenType::AND})) {
         Token op = previous();
         ExprPtr right = equality();
-        // TODO: return BinaryExpression node with AND op
+        STATS_NODE(BINARY);
+        expr = std::make_unique<BinaryExpression>(op.type, std::move(expr), std::move(right));
     }
 
     return expr;
@@ -372,7 +569,8 @@ ExprPtr Parser::equality() {
     while (match({TokenType::EQUAL, TokenType::NOT_EQUAL})) {
         Token op = previous();
         ExprPtr right = comparison();
-        // TODO: return BinaryExpression node with op
+        STATS_NODE(BINARY);
+        expr = std::make_unique<BinaryExpression>(op.type, std::move(expr), std::move(right));
     }
 
     return expr;
@@ -386,8 +584,7 @@ ExprPtr Parser::comparison() {
                   TokenType::GREATER_THAN, TokenType::GREATER_THAN_OR_EQUAL})) {
         Token op = previous();
         ExprPtr right = addition();
-        // TODO: return BinaryExpression node with op
-        // For now, placeholder:
+        STATS_NODE(BINARY);
         expr = std::make_unique<BinaryExpression>(op.type, std::move(expr), std::move(right));
     }
 
@@ -401,6 +598,7 @@ ExprPtr Parser::addition() {
     while (match({TokenType::ADD, TokenType::SUBTRACT})) {
         Token op = previous();
         ExprPtr right = multiplication();
+        STATS_NODE(BINARY);
         expr = std::make_unique<BinaryExpression>(op.type, std::move(expr), std::move(right));
     }
 
@@ -414,6 +612,7 @@ ExprPtr Parser::multiplication() {
     while (match({TokenType::MULTIPLY, TokenType::DIVIDE})) {
         Token op = previous();
         ExprPtr right = unary();
+        STATS_NODE(BINARY);
         expr = std::make_unique<BinaryExpression>(op.type, std::move(expr), std::move(right));
     }
 
@@ -425,6 +624,7 @@ ExprPtr Parser::unary() {
     if (match({TokenType::NOT, TokenType::SUBTRACT})) {
         Token op = previous();
         ExprPtr right = unary();
+        STATS_NODE(UNARY);
         return std::make_unique<UnaryExpression>(op.type, std::move(right));
     }
     return primary();
@@ -436,6 +636,7 @@ ExprPtr Parser::primary() {
                TokenType::STRING_LITERAL, TokenType::BOOLEAN_LITERAL,
                TokenType::NULL_LITERAL})) {
         Token literal = previous();
+        STATS_NODE(LITERAL);
         return std::make_unique<LiteralExpression>(literal);
     }
 
@@ -443,8 +644,10 @@ ExprPtr Parser::primary() {
         Token id = previous();
         // Check for function call: IDENTIFIER LEFT_PARENTHESIS ...
         if (check(TokenType::LEFT_PARENTHESIS)) {
+            STATS_NODE(VARIABLE);
             return function_call(std::make_unique<VariableExpression>(id.value));
         }
+        STATS_NODE(VARIABLE);
         return std::make_unique<VariableExpression>(id.value);
     }
 
@@ -462,7 +665,7 @@ ExprPtr Parser::primary() {
 }
 
 // FUNCTION_CALL ::= IDENTIFIER LEFT_PARENTHESIS [ argument_list ] RIGHT_PARENTHESIS ;
-ExprPtr Parser::function_call(const ExprPtr& callee) {
+ExprPtr Parser::function_call(ExprPtr callee) {
     // We assume callee is a VariableExpression for the function name
 
     if (!match({TokenType::LEFT_PARENTHESIS})) {
@@ -480,7 +683,8 @@ ExprPtr Parser::function_call(const ExprPtr& callee) {
         throw std::runtime_error("Parse error");
     }
 
-    return std::make_unique<CallExpression>(callee, std::move(args));
+    STATS_NODE(CALL);
+    return std::make_unique<CallExpression>(std::move(callee), std::move(args));
 }
 
 // argument_list ::= expression { COMMA expression } ;
@@ -501,6 +705,7 @@ std::vector<ExprPtr> Parser::parameter_list() {
             throw std::runtime_error("Parse error");
         }
         Token param = advance();
+        STATS_NODE(VARIABLE);
         params.push_back(std::make_unique<VariableExpression>(param.value));
     } while (match({TokenType::COMMA}));
     return params;
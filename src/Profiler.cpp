@@ -0,0 +1,204 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "Utf8.hpp"
+
+// The handler finds the interrupted thread's stack by kernel thread id:
+// thread_local storage may be allocated lazily and is not safe to touch there.
+struct CallStack {
+    std::atomic<pid_t> owner{0};
+    volatile std::sig_atomic_t depth = 0;
+    Profiler::Frame frames[Profiler::MaxDepth];
+};
+
+static CallStack callStacks[Profiler::MaxThreads];
+static std::atomic<Profiler*> active{nullptr};
+static std::atomic<int> handlersRunning{0};
+
+static pid_t thread_id() {
+    return (pid_t)syscall(SYS_gettid);
+}
+
+// Claims a CallStack for the calling thread on its first enter() and gives
+// it back when the thread exits. Never touched by the signal handler.
+struct StackSlot {
+    CallStack* stack = nullptr;
+
+    StackSlot() {
+        pid_t self = thread_id();
+        for (auto& candidate : callStacks) {
+            pid_t expected = 0;
+            if (candidate.owner.compare_exchange_strong(expected, self)) {
+                stack = &candidate;
+                return;
+            }
+        }
+    }
+
+    ~StackSlot() {
+        if (!stack) return;
+        stack->depth = 0;
+        stack->owner.store(0);
+    }
+};
+
+static thread_local StackSlot stackSlot;
+
+Profiler::Profiler(int frequency, size_t capacity)
+    : frequency(std::max(1, frequency)),
+      capacity(capacity),
+      frames(new Frame[capacity]),
+      sampleBuffer(new Sample[capacity / 8 + 1]),
+      sampleSlots(capacity / 8 + 1) {}
+
+Profiler::~Profiler() {
+    stop();
+}
+
+// --- Shadow stack ---
+// Depth is only published after the frame is written, so a signal landing
+// between the two lines sees the previous, still consistent, stack.
+void Profiler::enter(const FunctionDeclaration& function) {
+    CallStack* stack = stackSlot.stack;
+    if (!stack) return;
+
+    int depth = stack->depth;
+    if (depth < MaxDepth) {
+        Frame& frame = stack->frames[depth];
+        size_t length = std::min(function.name.size(), MaxName - 1);
+        while (length < function.name.size() && length > 0 && utf8_continuation(function.name[length])) length--;
+        std::memcpy(frame.name, function.name.data(), length);
+        frame.name[length] = '\0';
+        frame.line = function.line;
+    }
+    std::atomic_signal_fence(std::memory_order_release);
+    stack->depth = depth + 1;
+}
+
+void Profiler::leave() {
+    CallStack* stack = stackSlot.stack;
+    if (stack && stack->depth > 0) stack->depth = stack->depth - 1;
+}
+
+// --- Sampling ---
+bool Profiler::start() {
+    Profiler* expected = nullptr;
+    if (running || !active.compare_exchange_strong(expected, this)) return false;
+
+    struct sigaction action {};
+    action.sa_handler = on_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &previous);
+
+    long interval = 1000000 / frequency;
+    struct itimerval timer {};
+    timer.it_interval.tv_sec = interval / 1000000;
+    timer.it_interval.tv_usec = interval % 1000000;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        sigaction(SIGPROF, &previous, nullptr);
+        active.store(nullptr);
+        return false;
+    }
+
+    running = true;
+    return true;
+}
+
+// Handlers count themselves in before loading `active`, so once it is
+// cleared and the count drops to zero none can still hold this profiler.
+void Profiler::stop() {
+    if (!running) return;
+
+    sigset_t blocked;
+    sigset_t saved;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGPROF);
+    pthread_sigmask(SIG_BLOCK, &blocked, &saved);
+
+    struct itimerval timer {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    active.store(nullptr);
+    while (handlersRunning.load() != 0) std::this_thread::yield();
+
+    if ((previous.sa_flags & SA_SIGINFO) || previous.sa_handler != SIG_DFL) {
+        sigaction(SIGPROF, &previous, nullptr);
+    }
+    pthread_sigmask(SIG_SETMASK, &saved, nullptr);
+    running = false;
+}
+
+// Async-signal-safe: atomics, gettid and plain copies into preallocated
+// storage only.
+void Profiler::on_signal(int) {
+    int savedErrno = errno;
+    handlersRunning.fetch_add(1);
+    Profiler* profiler = active.load();
+    if (!profiler) {
+        handlersRunning.fetch_sub(1);
+        errno = savedErrno;
+        return;
+    }
+
+    const CallStack* stack = nullptr;
+    pid_t self = thread_id();
+    for (const auto& candidate : callStacks) {
+        if (candidate.owner.load(std::memory_order_relaxed) == self) {
+            stack = &candidate;
+            break;
+        }
+    }
+
+    int depth = stack ? std::min<int>((int)stack->depth, MaxDepth) : 0;
+    std::atomic_signal_fence(std::memory_order_acquire);
+
+    size_t slot = profiler->slotsUsed.fetch_add(1, std::memory_order_relaxed);
+    size_t begin = profiler->framesUsed.fetch_add(depth, std::memory_order_relaxed);
+    if (slot >= profiler->sampleSlots || begin + depth > profiler->capacity) {
+        if (slot < profiler->sampleSlots) profiler->sampleBuffer[slot] = Sample{0, -1};
+        profiler->droppedCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        for (int i = 0; i < depth; i++) {
+            profiler->frames[begin + i] = stack->frames[i];
+        }
+        profiler->sampleBuffer[slot] = Sample{begin, depth};
+        profiler->sampleCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    handlersRunning.fetch_sub(1);
+    errno = savedErrno;
+}
+
+// --- Output ---
+void Profiler::write_collapsed(std::ostream& out) const {
+    std::map<std::string, size_t> stacks;
+    size_t used = std::min(slotsUsed.load(), sampleSlots);
+
+    for (size_t i = 0; i < used; i++) {
+        const Sample& sample = sampleBuffer[i];
+        if (sample.depth < 0) continue;
+
+        std::string stack = "<script>";
+        for (int f = 0; f < sample.depth; f++) {
+            const Frame& frame = frames[sample.begin + f];
+            stack += ";";
+            stack += frame.name;
+            stack += ":" + std::to_string(frame.line);
+        }
+        stacks[stack]++;
+    }
+
+    for (const auto& entry : stacks) {
+        out << entry.first << " " << entry.second << "\n";
+    }
+}
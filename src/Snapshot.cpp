@@ -0,0 +1,174 @@
+#include "Snapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "Parser.hpp"
+
+static const char SNAPSHOT_MAGIC[8] = {'A', 'G', 'S', 'N', 'A', 'P', '\0', '\0'};
+
+// --- Writing ---
+void write_snapshot(const std::string& path, const std::vector<Token>& tokens) {
+    if (tokens.empty() || tokens.back().type != TokenType::END_OF_FILE) {
+        throw std::runtime_error("Snapshot token stream must end with END_OF_FILE");
+    }
+    if (tokens.size() > UINT32_MAX) {
+        throw std::runtime_error("Too many tokens for a snapshot");
+    }
+
+    StringPool strings;
+    std::vector<TokenRecord> tokenRecords;
+    tokenRecords.reserve(tokens.size());
+    for (const auto& token : tokens) tokenRecords.push_back(to_record(token, strings));
+
+    // Function chunks are parsed lazily just to find the name, parameters and
+    // body range; anything else is stored as a range and reparsed on load.
+    std::vector<FunctionRecord> functionRecords;
+    std::vector<StringRef> parameterRecords;
+    std::vector<DeclarationRecord> declarationRecords;
+    for (const auto& [begin, end] : Parser::split_top_level(tokens)) {
+        DeclarationRecord declaration{(uint32_t)begin, (uint32_t)end, -1, 0};
+
+        TokenType first = tokens[begin].type;
+        if (first == TokenType::FUNCTION || first == TokenType::MEMO) {
+            std::vector<StmtPtr> chunk = Parser(tokens, begin, end, true).parse();
+            auto* function = chunk.size() == 1 ? dynamic_cast<FunctionDeclaration*>(chunk[0].get()) : nullptr;
+            if (function && function->isLazy()) {
+                FunctionRecord record{};
+                record.name = strings.add(function->name);
+                record.firstParameter = (uint32_t)parameterRecords.size();
+                record.parameterCount = (uint32_t)function->parameters.size();
+                record.bodyBegin = (uint32_t)function->bodyBegin;
+                record.bodyEnd = (uint32_t)function->bodyEnd;
+                record.line = function->line;
+                record.flags = function->memoize ? FUNCTION_MEMO : 0;
+                for (const auto& parameter : function->parameters) parameterRecords.push_back(strings.add(parameter));
+
+                declaration.function = (int32_t)functionRecords.size();
+                functionRecords.push_back(record);
+            }
+        }
+        declarationRecords.push_back(declaration);
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.tokenCount = (uint32_t)tokenRecords.size();
+    header.functionCount = (uint32_t)functionRecords.size();
+    header.parameterCount = (uint32_t)parameterRecords.size();
+    header.declarationCount = (uint32_t)declarationRecords.size();
+    header.stringsSize = (uint32_t)strings.data().size();
+
+    std::string image(sizeof(header), '\0');
+    header.tokens = append_records(image, tokenRecords.data(), tokenRecords.size());
+    header.functions = append_records(image, functionRecords.data(), functionRecords.size());
+    header.parameters = append_records(image, parameterRecords.data(), parameterRecords.size());
+    header.declarations = append_records(image, declarationRecords.data(), declarationRecords.size());
+    header.strings = append_records(image, strings.data().data(), strings.data().size());
+    std::memcpy(&image[0], &header, sizeof(header));
+
+    std::ofstream out(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(image.data(), image.size());
+    if (!out) {
+        throw std::runtime_error("Could not write snapshot: " + path);
+    }
+}
+
+// --- Reading ---
+Snapshot::Snapshot(const std::string& path) : file(path) {
+    head = file.records<SnapshotHeader>(0, 1);
+    if (!head || std::memcmp(head->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        throw std::runtime_error("Not a snapshot: " + path);
+    }
+    if (head->version != SNAPSHOT_VERSION) {
+        throw std::runtime_error("Unsupported snapshot version: " + path);
+    }
+
+    tokenTable = file.records<TokenRecord>(head->tokens, head->tokenCount);
+    functionTable = file.records<FunctionRecord>(head->functions, head->functionCount);
+    parameterTable = file.records<StringRef>(head->parameters, head->parameterCount);
+    declarationTable = file.records<DeclarationRecord>(head->declarations, head->declarationCount);
+    const char* pool = file.records<char>(head->strings, head->stringsSize);
+    if (!tokenTable || !functionTable || !parameterTable || !declarationTable || !pool) {
+        throw std::runtime_error("Truncated snapshot: " + path);
+    }
+    strings = std::string_view(pool, head->stringsSize);
+
+    // Everything the loaders index with, so they need no further checks.
+    for (uint32_t i = 0; i < head->functionCount; i++) {
+        const FunctionRecord& function = functionTable[i];
+        bool parametersOk = function.firstParameter <= head->parameterCount &&
+                            function.parameterCount <= head->parameterCount - function.firstParameter;
+        if (!parametersOk || function.bodyBegin >= function.bodyEnd || function.bodyEnd > head->tokenCount) {
+            throw std::runtime_error("Corrupt snapshot function table: " + path);
+        }
+    }
+    for (uint32_t i = 0; i < head->declarationCount; i++) {
+        const DeclarationRecord& declaration = declarationTable[i];
+        bool functionOk = declaration.function < (int32_t)head->functionCount;
+        if (!functionOk || declaration.begin > declaration.end || declaration.end > head->tokenCount) {
+            throw std::runtime_error("Corrupt snapshot declaration table: " + path);
+        }
+    }
+}
+
+std::string_view Snapshot::string(StringRef ref) const {
+    if (ref.offset > strings.size() || ref.length > strings.size() - ref.offset) {
+        throw std::runtime_error("Corrupt snapshot string reference");
+    }
+    return strings.substr(ref.offset, ref.length);
+}
+
+std::vector<Token> Snapshot::load_tokens(bool bodies) const {
+    std::vector<Token> result(head->tokenCount);
+    if (bodies) {
+        load_token_range(result, 0, head->tokenCount);
+        return result;
+    }
+
+    // Function records are in source order, so the gaps between their
+    // bodies are everything the loader itself parses.
+    size_t next = 0;
+    for (uint32_t i = 0; i < head->functionCount; i++) {
+        const FunctionRecord& function = functionTable[i];
+        if (function.bodyBegin < next) continue;
+        load_token_range(result, next, function.bodyBegin);
+        next = function.bodyEnd;
+    }
+    load_token_range(result, next, head->tokenCount);
+    return result;
+}
+
+void Snapshot::load_token_range(std::vector<Token>& tokens, size_t begin, size_t end) const {
+    end = std::min<size_t>(end, std::min<size_t>(tokens.size(), head->tokenCount));
+    for (size_t i = begin; i < end; i++) tokens[i] = from_record(tokenTable[i], strings);
+}
+
+std::vector<StmtPtr> Snapshot::load_program(const std::vector<Token>& tokens) const {
+    std::vector<StmtPtr> program;
+    for (uint32_t i = 0; i < head->declarationCount; i++) {
+        const DeclarationRecord& declaration = declarationTable[i];
+        if (declaration.function < 0) {
+            for (auto& statement : Parser(tokens, declaration.begin, declaration.end, true).parse()) {
+                program.push_back(std::move(statement));
+            }
+            continue;
+        }
+
+        const FunctionRecord& record = functionTable[declaration.function];
+        std::vector<std::string> names;
+        for (uint32_t p = 0; p < record.parameterCount; p++) {
+            names.emplace_back(string(parameterTable[record.firstParameter + p]));
+        }
+
+        STATS_NODE(FUNCTION);
+        auto function = std::make_unique<FunctionDeclaration>(std::string(string(record.name)), std::move(names), nullptr);
+        function->bodyBegin = record.bodyBegin;
+        function->bodyEnd = record.bodyEnd;
+        function->line = record.line;
+        function->memoize = (record.flags & FUNCTION_MEMO) != 0;
+        program.push_back(std::move(function));
+    }
+    return program;
+}
@@ -0,0 +1,126 @@
+#ifdef AGSCRIPT_STATS
+#include "Stats.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <malloc.h>
+
+static std::atomic<long long> phaseTimes[(size_t)Phase::COUNT];
+static std::atomic<size_t> phaseEntries[(size_t)Phase::COUNT];
+static std::atomic<size_t> counters[(size_t)Counter::COUNT];
+static std::atomic<size_t> nodeCounts[(size_t)NodeKind::COUNT];
+
+static std::atomic<size_t> allocationCount{0};
+static std::atomic<size_t> liveBytes{0};
+static std::atomic<size_t> peakBytes{0};
+
+static const char* counterNames[] = {"bytes", "tokens", "inlined_calls", "common_subexpressions", "hoisted_expressions", "dead_statements", "memo_hits", "memo_misses"};
+static const char* nodeNames[] = {
+    "LiteralExpression", "VariableExpression", "AssignExpression", "UnaryExpression", "BinaryExpression",
+    "CallExpression", "ExpressionStatement", "VariableDeclaration", "BlockStatement",
+    "IfStatement", "WhileStatement", "ForStatement", "ParallelForStatement", "ReturnStatement",
+    "ImportDeclaration", "FunctionDeclaration",
+};
+
+// --- Heap tracking ---
+// Replacing the global allocator is what makes these builds unsuitable for
+// production; release builds never see this file's contents.
+void* operator new(size_t size) {
+    void* pointer = std::malloc(size ? size : 1);
+    if (!pointer) throw std::bad_alloc();
+
+    size_t usable = malloc_usable_size(pointer);
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    size_t live = liveBytes.fetch_add(usable, std::memory_order_relaxed) + usable;
+    size_t peak = peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (!pointer) return;
+    liveBytes.fetch_sub(malloc_usable_size(pointer), std::memory_order_relaxed);
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+// --- Counters ---
+void Stats::add(Counter counter, size_t amount) {
+    counters[(size_t)counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Stats::node(NodeKind kind) {
+    nodeCounts[(size_t)kind].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::record(Phase phase, std::chrono::steady_clock::duration elapsed) {
+    long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    phaseTimes[(size_t)phase].fetch_add(ns, std::memory_order_relaxed);
+    phaseEntries[(size_t)phase].fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t Stats::nodes(NodeKind kind) {
+    return nodeCounts[(size_t)kind].load(std::memory_order_relaxed);
+}
+
+size_t Stats::allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+// --- Output ---
+// Phases that never ran are left out rather than reported as zero.
+void Stats::report(std::ostream& out, bool json) {
+    std::ios_base::fmtflags flags = out.flags();
+
+    if (json) {
+        out << "{\"phases_ms\": {";
+        const char* separator = "";
+        for (size_t i = 0; i < (size_t)Phase::COUNT; i++) {
+            if (!phaseEntries[i]) continue;
+            out << separator << "\"" << phase_name((Phase)i) << "\": " << std::fixed << std::setprecision(3) << phaseTimes[i] / 1e6;
+            separator = ", ";
+        }
+        out << "}, \"counters\": {";
+        for (size_t i = 0; i < (size_t)Counter::COUNT; i++) {
+            out << "\"" << counterNames[i] << "\": " << counters[i] << ", ";
+        }
+        out << "\"allocations\": " << allocationCount << ", \"peak_heap_bytes\": " << peakBytes << "}, \"nodes\": {";
+        separator = "";
+        for (size_t i = 0; i < (size_t)NodeKind::COUNT; i++) {
+            if (!nodeCounts[i]) continue;
+            out << separator << "\"" << nodeNames[i] << "\": " << nodeCounts[i];
+            separator = ", ";
+        }
+        out << "}}\n";
+        out.flags(flags);
+        return;
+    }
+
+    out << std::left << std::setw(24) << "phase" << std::right << std::setw(14) << "time (ms)" << "\n";
+    for (size_t i = 0; i < (size_t)Phase::COUNT; i++) {
+        if (!phaseEntries[i]) continue;
+        out << std::left << std::setw(24) << phase_name((Phase)i) << std::right << std::setw(14)
+            << std::fixed << std::setprecision(3) << phaseTimes[i] / 1e6 << "\n";
+    }
+
+    out << "\n" << std::left << std::setw(24) << "counter" << std::right << std::setw(14) << "value" << "\n";
+    for (size_t i = 0; i < (size_t)Counter::COUNT; i++) {
+        out << std::left << std::setw(24) << counterNames[i] << std::right << std::setw(14) << counters[i] << "\n";
+    }
+    out << std::left << std::setw(24) << "allocations" << std::right << std::setw(14) << allocationCount << "\n";
+    out << std::left << std::setw(24) << "peak heap (bytes)" << std::right << std::setw(14) << peakBytes << "\n";
+
+    out << "\n" << std::left << std::setw(24) << "AST node" << std::right << std::setw(14) << "count" << "\n";
+    for (size_t i = 0; i < (size_t)NodeKind::COUNT; i++) {
+        if (!nodeCounts[i]) continue;
+        out << std::left << std::setw(24) << nodeNames[i] << std::right << std::setw(14) << nodeCounts[i] << "\n";
+    }
+
+    out.flags(flags);
+}
+#endif
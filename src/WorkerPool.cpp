@@ -0,0 +1,117 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+static thread_local const WorkerPool* currentPool = nullptr;
+static thread_local int currentIndex = -1;
+
+WorkerPool::WorkerPool(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < threads; i++) {
+        queues.push_back(std::make_unique<Queue>());
+        allocators.push_back(std::make_unique<TrackingAllocator>());
+    }
+    for (unsigned i = 0; i < threads; i++) {
+        workers.emplace_back([this, i]() { run(i); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+int WorkerPool::current_worker() {
+    return currentIndex;
+}
+
+void WorkerPool::submit(Job job) {
+    size_t target = currentPool == this ? (size_t)currentIndex : nextQueue++ % queues.size();
+    pending++;
+
+    // `queued` only grows under sleepLock, which sleeping workers check their
+    // predicate under, so a wakeup cannot be lost. It grows before the job
+    // is visible, so the decrement after take() can never run first.
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> guard(queues[target]->lock);
+        queues[target]->jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void WorkerPool::wait() {
+    if (currentPool == this) {
+        throw std::logic_error("WorkerPool::wait() called from one of its own jobs");
+    }
+
+    std::unique_lock<std::mutex> guard(sleepLock);
+    idle.wait(guard, [this]() { return pending == 0; });
+
+    if (failure) {
+        std::exception_ptr error = failure;
+        failure = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+// Own queue from the back, then everyone else's from the front.
+bool WorkerPool::take(size_t self, Job& job) {
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        Queue& victim = *queues[(self + offset) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::run(size_t self) {
+    currentPool = this;
+    currentIndex = (int)self;
+    AllocatorScope scope(*allocators[self]);
+
+    while (true) {
+        Job job;
+        if (take(self, job)) {
+            queued--;
+            try {
+                job();
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(sleepLock);
+                if (!failure) failure = std::current_exception();
+            }
+
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> guard(sleepLock);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
@@ -0,0 +1,196 @@
+#include "passes/AstUtil.hpp"
+
+ExprPtr clone(const Expression& expression) {
+    if (auto* literal = dynamic_cast<const LiteralExpression*>(&expression)) {
+        return std::make_unique<LiteralExpression>(literal->literal);
+    }
+    if (auto* variable = dynamic_cast<const VariableExpression*>(&expression)) {
+        return std::make_unique<VariableExpression>(variable->name);
+    }
+    if (auto* assign = dynamic_cast<const AssignExpression*>(&expression)) {
+        return std::make_unique<AssignExpression>(assign->name, clone(*assign->value));
+    }
+    if (auto* unary = dynamic_cast<const UnaryExpression*>(&expression)) {
+        return std::make_unique<UnaryExpression>(unary->op, clone(*unary->right));
+    }
+    if (auto* binary = dynamic_cast<const BinaryExpression*>(&expression)) {
+        return std::make_unique<BinaryExpression>(binary->op, clone(*binary->left), clone(*binary->right));
+    }
+    auto& call = dynamic_cast<const CallExpression&>(expression);
+    std::vector<ExprPtr> arguments;
+    for (const auto& argument : call.arguments) arguments.push_back(clone(*argument));
+    return std::make_unique<CallExpression>(clone(*call.callee), std::move(arguments));
+}
+
+bool may_raise(const Expression& expression) {
+    auto* binary = dynamic_cast<const BinaryExpression*>(&expression);
+    return binary && binary->op == TokenType::DIVIDE;
+}
+
+bool is_pure(const Expression& expression) {
+    if (dynamic_cast<const CallExpression*>(&expression) || dynamic_cast<const AssignExpression*>(&expression) ||
+        may_raise(expression)) {
+        return false;
+    }
+    bool pure = true;
+    for_each_child(const_cast<Expression&>(expression), [&](ExprPtr& child) {
+        pure = pure && is_pure(*child);
+    });
+    return pure;
+}
+
+size_t expression_size(const Expression& expression) {
+    size_t size = 1;
+    for_each_child(const_cast<Expression&>(expression), [&](ExprPtr& child) {
+        size += expression_size(*child);
+    });
+    return size;
+}
+
+void for_each_child(Expression& expression, const std::function<void(ExprPtr&)>& visit) {
+    if (auto* assign = dynamic_cast<AssignExpression*>(&expression)) {
+        visit(assign->value);
+    } else if (auto* unary = dynamic_cast<UnaryExpression*>(&expression)) {
+        visit(unary->right);
+    } else if (auto* binary = dynamic_cast<BinaryExpression*>(&expression)) {
+        visit(binary->left);
+        visit(binary->right);
+    } else if (auto* call = dynamic_cast<CallExpression*>(&expression)) {
+        visit(call->callee);
+        for (auto& argument : call->arguments) visit(argument);
+    }
+}
+
+// --- Statement walkers ---
+// Calls `expressions` on each expression slot and `statements` on each child
+// statement slot of one statement, without recursing.
+static void for_each_slot(Statement& statement,
+                          const std::function<void(ExprPtr&)>& expressions,
+                          const std::function<void(StmtPtr&)>& statements) {
+    auto visit = [&](ExprPtr& expression) {
+        if (expression) expressions(expression);
+    };
+    auto descend = [&](StmtPtr& child) {
+        if (child) statements(child);
+    };
+
+    if (auto* expression = dynamic_cast<ExpressionStatement*>(&statement)) {
+        visit(expression->expression);
+    } else if (auto* variable = dynamic_cast<VariableDeclaration*>(&statement)) {
+        visit(variable->initializer);
+    } else if (auto* block = dynamic_cast<BlockStatement*>(&statement)) {
+        for (auto& child : block->statements) descend(child);
+    } else if (auto* branch = dynamic_cast<IfStatement*>(&statement)) {
+        visit(branch->condition);
+        descend(branch->thenBranch);
+        descend(branch->elseBranch);
+    } else if (auto* loop = dynamic_cast<WhileStatement*>(&statement)) {
+        visit(loop->condition);
+        descend(loop->body);
+    } else if (auto* loop = dynamic_cast<ForStatement*>(&statement)) {
+        descend(loop->initializer);
+        visit(loop->condition);
+        visit(loop->increment);
+        descend(loop->body);
+    } else if (auto* loop = dynamic_cast<ParallelForStatement*>(&statement)) {
+        visit(loop->iterable);
+        descend(loop->body);
+    } else if (auto* ret = dynamic_cast<ReturnStatement*>(&statement)) {
+        visit(ret->value);
+    } else if (auto* function = dynamic_cast<FunctionDeclaration*>(&statement)) {
+        descend(function->body);
+    }
+}
+
+void for_each_child(Statement& statement, const std::function<void(StmtPtr&)>& visit) {
+    for_each_slot(statement, [](ExprPtr&) {}, visit);
+}
+
+void for_each_expression(Statement& statement, const std::function<void(ExprPtr&)>& visit) {
+    for_each_slot(statement, visit, [&](StmtPtr& child) { for_each_expression(*child, visit); });
+}
+
+void for_each_block(Statement& statement, const std::function<void(std::vector<StmtPtr>&)>& visit) {
+    for_each_slot(statement, [](ExprPtr&) {}, [&](StmtPtr& child) { for_each_block(*child, visit); });
+    if (auto* block = dynamic_cast<BlockStatement*>(&statement)) visit(block->statements);
+}
+
+void collect_names(Expression& expression, std::unordered_set<std::string>& names) {
+    if (auto* variable = dynamic_cast<VariableExpression*>(&expression)) {
+        names.insert(variable->name);
+    } else if (auto* assign = dynamic_cast<AssignExpression*>(&expression)) {
+        names.insert(assign->name);
+    }
+    for_each_child(expression, [&](ExprPtr& child) { collect_names(*child, names); });
+}
+
+void collect_names(Statement& statement, std::unordered_set<std::string>& names) {
+    auto* loop = dynamic_cast<ParallelForStatement*>(&statement);
+    if (loop && !loop->target.empty()) names.insert(loop->target);
+
+    for_each_slot(statement,
+                  [&](ExprPtr& expression) { collect_names(*expression, names); },
+                  [&](StmtPtr& child) { collect_names(*child, names); });
+}
+
+static const char* spelling(TokenType op) {
+    switch (op) {
+        case TokenType::ADD: return "+";
+        case TokenType::SUBTRACT: return "-";
+        case TokenType::MULTIPLY: return "*";
+        case TokenType::DIVIDE: return "/";
+        case TokenType::EQUAL: return "==";
+        case TokenType::NOT_EQUAL: return "!=";
+        case TokenType::LESS_THAN: return "<";
+        case TokenType::LESS_THAN_OR_EQUAL: return "<=";
+        case TokenType::GREATER_THAN: return ">";
+        case TokenType::GREATER_THAN_OR_EQUAL: return ">=";
+        case TokenType::AND: return "and";
+        case TokenType::OR: return "or";
+        case TokenType::NOT: return "!";
+        default: return "?";
+    }
+}
+
+std::string to_source(const Expression& expression) {
+    if (auto* literal = dynamic_cast<const LiteralExpression*>(&expression)) {
+        if (literal->literal.type == TokenType::STRING_LITERAL) return "\"" + literal->literal.value + "\"";
+        return literal->literal.value;
+    }
+    if (auto* variable = dynamic_cast<const VariableExpression*>(&expression)) {
+        return variable->name;
+    }
+    if (auto* assign = dynamic_cast<const AssignExpression*>(&expression)) {
+        return "(" + assign->name + " = " + to_source(*assign->value) + ")";
+    }
+    if (auto* unary = dynamic_cast<const UnaryExpression*>(&expression)) {
+        return spelling(unary->op) + to_source(*unary->right);
+    }
+    if (auto* binary = dynamic_cast<const BinaryExpression*>(&expression)) {
+        return "(" + to_source(*binary->left) + " " + spelling(binary->op) + " " + to_source(*binary->right) + ")";
+    }
+    auto& call = dynamic_cast<const CallExpression&>(expression);
+    std::string text = to_source(*call.callee) + "(";
+    for (size_t i = 0; i < call.arguments.size(); i++) {
+        if (i > 0) text += ", ";
+        text += to_source(*call.arguments[i]);
+    }
+    return text + ")";
+}
+
+std::unordered_set<std::string> local_names(FunctionDeclaration& function) {
+    std::unordered_set<std::string> names(function.parameters.begin(), function.parameters.end());
+    if (!function.body) return names;
+
+    std::function<void(Statement&)> declare = [&](Statement& statement) {
+        if (auto* variable = dynamic_cast<VariableDeclaration*>(&statement)) {
+            names.insert(variable->name);
+        } else if (auto* loop = dynamic_cast<ParallelForStatement*>(&statement)) {
+            names.insert(loop->variable);
+            if (!loop->target.empty()) names.insert(loop->target);
+        }
+        for_each_child(statement, [&](StmtPtr& child) { declare(*child); });
+    };
+    declare(*function.body);
+    return names;
+}
@@ -0,0 +1,162 @@
+#include "passes/CommonSubexpression.hpp"
+#include <algorithm>
+#include <ostream>
+#include "passes/AstUtil.hpp"
+
+static void effects(Expression& expression, std::unordered_set<std::string>& written, bool& calls) {
+    if (auto* assign = dynamic_cast<AssignExpression*>(&expression)) written.insert(assign->name);
+    if (dynamic_cast<CallExpression*>(&expression)) calls = true;
+    for_each_child(expression, [&](ExprPtr& child) { effects(*child, written, calls); });
+}
+
+static bool short_circuits(const Expression& expression) {
+    auto* binary = dynamic_cast<const BinaryExpression*>(&expression);
+    return binary && (binary->op == TokenType::AND || binary->op == TokenType::OR);
+}
+
+// Structural key with each variable tagged by its current version, or empty
+// when the expression may not be shared.
+std::string CommonSubexpression::key(const Expression& expression, const std::unordered_set<std::string>& written, bool calls) const {
+    if (auto* literal = dynamic_cast<const LiteralExpression*>(&expression)) {
+        return std::to_string((int)literal->literal.type) + ":" + literal->literal.value;
+    }
+    if (auto* variable = dynamic_cast<const VariableExpression*>(&expression)) {
+        bool local = locals->count(variable->name) > 0;
+        if (written.count(variable->name) || (calls && !local)) return "";
+
+        // A global also changes behind every call, so it carries both counts.
+        auto it = versions.find(variable->name);
+        std::string version = std::to_string(it == versions.end() ? 0 : it->second);
+        return variable->name + "@" + version + (local ? "" : "g" + std::to_string(globalVersion));
+    }
+    if (auto* unary = dynamic_cast<const UnaryExpression*>(&expression)) {
+        std::string right = key(*unary->right, written, calls);
+        return right.empty() ? "" : "(" + std::to_string((int)unary->op) + " " + right + ")";
+    }
+    if (auto* binary = dynamic_cast<const BinaryExpression*>(&expression)) {
+        if (may_raise(*binary)) return "";
+        std::string left = key(*binary->left, written, calls);
+        std::string right = left.empty() ? "" : key(*binary->right, written, calls);
+        return right.empty() ? "" : "(" + left + " " + std::to_string((int)binary->op) + " " + right + ")";
+    }
+    return ""; // calls and assignments are not pure
+}
+
+void CommonSubexpression::collect(ExprPtr& expression, size_t statement, const std::unordered_set<std::string>& written, bool calls) {
+    bool leaf = dynamic_cast<LiteralExpression*>(expression.get()) || dynamic_cast<VariableExpression*>(expression.get());
+    if (leaf) return;
+
+    std::string shared = key(*expression, written, calls);
+    if (!shared.empty()) {
+        Occurrences& seen = occurrences[shared];
+        if (seen.slots.empty()) {
+            seen.statement = statement;
+            seen.size = expression_size(*expression);
+            firstSeen.push_back(shared);
+        }
+        seen.slots.push_back(&expression);
+        if (seen.slots.size() > 1) return; // the whole repeat is replaced
+    }
+
+    if (short_circuits(*expression)) {
+        collect(static_cast<BinaryExpression&>(*expression).left, statement, written, calls);
+        return;
+    }
+    for_each_child(*expression, [&](ExprPtr& child) { collect(child, statement, written, calls); });
+}
+
+// Smaller expressions first: one nested in the first occurrence of a larger
+// one is replaced in place, and the larger one's temporary then reads it.
+void CommonSubexpression::flush(std::unordered_map<size_t, std::vector<StmtPtr>>& lets) {
+    std::stable_sort(firstSeen.begin(), firstSeen.end(), [&](const std::string& a, const std::string& b) {
+        return occurrences[a].size < occurrences[b].size;
+    });
+
+    for (const auto& shared : firstSeen) {
+        Occurrences& seen = occurrences[shared];
+        if (seen.slots.size() < 2) continue;
+
+        std::string name = "__cse" + std::to_string(temporaries++);
+        if (report) {
+            *report << "cse: " << to_source(**seen.slots[0]) << " computed once as " << name << " instead of "
+                    << seen.slots.size() << " times in " << function->name << "\n";
+        }
+
+        lets[seen.statement].push_back(std::make_unique<VariableDeclaration>(name, std::move(*seen.slots[0])));
+        for (ExprPtr* slot : seen.slots) *slot = std::make_unique<VariableExpression>(name);
+        eliminated += seen.slots.size() - 1;
+    }
+
+    occurrences.clear();
+    firstSeen.clear();
+}
+
+void CommonSubexpression::block(std::vector<StmtPtr>& statements) {
+    versions.clear();
+    std::unordered_map<size_t, std::vector<StmtPtr>> lets;
+
+    for (size_t i = 0; i < statements.size(); i++) {
+        Statement* statement = statements[i].get();
+        if (!statement) continue;
+
+        ExprPtr* slot = nullptr;
+        std::string declared;
+        bool ends = false;
+        if (auto* expression = dynamic_cast<ExpressionStatement*>(statement)) {
+            slot = &expression->expression;
+        } else if (auto* variable = dynamic_cast<VariableDeclaration*>(statement)) {
+            slot = &variable->initializer;
+            declared = variable->name;
+        } else if (auto* branch = dynamic_cast<IfStatement*>(statement)) {
+            slot = &branch->condition;
+            ends = true;
+        } else if (auto* ret = dynamic_cast<ReturnStatement*>(statement)) {
+            slot = &ret->value;
+            ends = true;
+        } else {
+            flush(lets);
+            continue;
+        }
+
+        std::unordered_set<std::string> written;
+        bool calls = false;
+        if (*slot) {
+            effects(**slot, written, calls);
+            collect(*slot, i, written, calls);
+        }
+
+        if (!declared.empty()) written.insert(declared);
+        for (const auto& name : written) versions[name]++;
+        if (calls) globalVersion++;
+
+        if (ends) flush(lets);
+    }
+    flush(lets);
+    if (lets.empty()) return;
+
+    std::vector<StmtPtr> rewritten;
+    for (size_t i = 0; i < statements.size(); i++) {
+        auto it = lets.find(i);
+        if (it != lets.end()) {
+            for (auto& let : it->second) rewritten.push_back(std::move(let));
+        }
+        rewritten.push_back(std::move(statements[i]));
+    }
+    statements = std::move(rewritten);
+}
+
+size_t CommonSubexpression::run(std::vector<StmtPtr>& program) {
+    eliminated = 0;
+    for (auto& statement : program) {
+        auto* declaration = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (!declaration || !declaration->body) continue; // lazy bodies have no nodes yet
+
+        std::unordered_set<std::string> names = local_names(*declaration);
+        function = declaration;
+        locals = &names;
+        for_each_block(*declaration->body, [&](std::vector<StmtPtr>& statements) { block(statements); });
+    }
+    function = nullptr;
+    locals = nullptr;
+    return eliminated;
+}
@@ -0,0 +1,53 @@
+#include "passes/DeadCode.hpp"
+#include <unordered_set>
+#include "passes/AstUtil.hpp"
+
+// One pass over every block of `function`; true if anything was removed.
+bool DeadCode::sweep(FunctionDeclaration& function) {
+    std::unordered_set<std::string> used;
+    collect_names(*function.body, used);
+
+    size_t before = removed;
+    for_each_block(*function.body, [&](std::vector<StmtPtr>& statements) {
+        std::vector<StmtPtr> live;
+        size_t i = 0;
+        while (i < statements.size()) {
+            StmtPtr& statement = statements[i++];
+            if (!statement) continue; // empty statement
+
+            if (auto* expression = dynamic_cast<ExpressionStatement*>(statement.get())) {
+                if (is_pure(*expression->expression)) {
+                    removed++;
+                    continue;
+                }
+            } else if (auto* variable = dynamic_cast<VariableDeclaration*>(statement.get())) {
+                bool pure = !variable->initializer || is_pure(*variable->initializer);
+                if (pure && !used.count(variable->name)) {
+                    removed++;
+                    continue;
+                }
+            }
+
+            bool returns = dynamic_cast<ReturnStatement*>(statement.get()) != nullptr;
+            live.push_back(std::move(statement));
+            if (returns) break;
+        }
+
+        for (; i < statements.size(); i++) {
+            if (statements[i]) removed++; // unreachable after the return
+        }
+        statements = std::move(live);
+    });
+    return removed != before;
+}
+
+size_t DeadCode::run(std::vector<StmtPtr>& program) {
+    removed = 0;
+    for (auto& statement : program) {
+        auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (!function || !function->body) continue; // lazy bodies have no nodes yet
+
+        while (sweep(*function)) {}
+    }
+    return removed;
+}
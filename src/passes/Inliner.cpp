@@ -0,0 +1,142 @@
+#include "passes/Inliner.hpp"
+#include <algorithm>
+#include "passes/AstUtil.hpp"
+
+// The expression of a body that is exactly `{ return expression; }`, ignoring
+// empty statements; nullptr for anything else.
+static ExprPtr* result_slot(const FunctionDeclaration& function) {
+    auto* block = dynamic_cast<BlockStatement*>(function.body.get());
+    if (!block) return nullptr;
+
+    ReturnStatement* only = nullptr;
+    for (auto& statement : block->statements) {
+        if (!statement) continue;
+        if (only) return nullptr;
+        only = dynamic_cast<ReturnStatement*>(statement.get());
+        if (!only) return nullptr;
+    }
+    return only && only->value ? &only->value : nullptr;
+}
+
+static void collect_assigned(Expression& expression, std::unordered_set<std::string>& names) {
+    if (auto* assign = dynamic_cast<AssignExpression*>(&expression)) names.insert(assign->name);
+    for_each_child(expression, [&](ExprPtr& child) { collect_assigned(*child, names); });
+}
+
+static void count_uses(const Expression& expression, const std::string& name, size_t& uses) {
+    auto* variable = dynamic_cast<const VariableExpression*>(&expression);
+    if (variable && variable->name == name) uses++;
+    for_each_child(const_cast<Expression&>(expression), [&](ExprPtr& child) { count_uses(*child, name, uses); });
+}
+
+static ExprPtr substitute(const Expression& expression, const FunctionDeclaration& function, const std::vector<ExprPtr>& arguments) {
+    if (auto* variable = dynamic_cast<const VariableExpression*>(&expression)) {
+        auto it = std::find(function.parameters.begin(), function.parameters.end(), variable->name);
+        if (it != function.parameters.end()) return clone(*arguments[it - function.parameters.begin()]);
+    }
+
+    ExprPtr copy = clone(expression);
+    for_each_child(*copy, [&](ExprPtr& child) { child = substitute(*child, function, arguments); });
+    return copy;
+}
+
+void Inliner::find_candidates(std::vector<StmtPtr>& program) {
+    std::unordered_map<std::string, size_t> declarations;
+    std::unordered_set<std::string> assigned;
+    for (auto& statement : program) {
+        if (!statement) continue;
+        if (auto* function = dynamic_cast<FunctionDeclaration*>(statement.get())) {
+            declarations[function->name]++;
+        } else if (auto* variable = dynamic_cast<VariableDeclaration*>(statement.get())) {
+            declarations[variable->name]++;
+        }
+        for_each_expression(*statement, [&](ExprPtr& expression) { collect_assigned(*expression, assigned); });
+    }
+
+    for (auto& statement : program) {
+        auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (!function || !result_slot(*function)) continue;
+        if (declarations[function->name] != 1 || assigned.count(function->name)) continue;
+        candidates[function->name] = function;
+    }
+}
+
+bool Inliner::can_inline(const FunctionDeclaration& function, const std::vector<ExprPtr>& arguments) const {
+    if (arguments.size() != function.parameters.size()) return false;
+    if (std::find(expanding.begin(), expanding.end(), function.name) != expanding.end()) return false;
+
+    ExprPtr* result = result_slot(function);
+    if (!result || expression_size(**result) > budget) return false;
+
+    std::unordered_set<std::string> assigned;
+    collect_assigned(**result, assigned);
+    if (!assigned.empty()) return false;
+
+    for (size_t i = 0; i < arguments.size(); i++) {
+        if (!is_pure(*arguments[i])) return false;
+
+        size_t uses = 0;
+        count_uses(**result, function.parameters[i], uses);
+        bool trivial = dynamic_cast<LiteralExpression*>(arguments[i].get()) || dynamic_cast<VariableExpression*>(arguments[i].get());
+        if (uses > 1 && !trivial) return false;
+    }
+
+    std::unordered_set<std::string> names;
+    collect_names(**result, names);
+    if (names.count(function.name)) return false; // directly recursive
+
+    for (const auto& name : names) {
+        bool parameter = std::find(function.parameters.begin(), function.parameters.end(), name) != function.parameters.end();
+        if (!parameter && locals && locals->count(name)) return false;
+    }
+    return true;
+}
+
+// Bottom-up, so arguments are already expanded (and possibly pure) by the
+// time their call is considered.
+void Inliner::rewrite(ExprPtr& expression) {
+    for_each_child(*expression, [&](ExprPtr& child) { rewrite(child); });
+
+    auto* call = dynamic_cast<CallExpression*>(expression.get());
+    if (!call) return;
+    auto* callee = dynamic_cast<VariableExpression*>(call->callee.get());
+    if (!callee) return;
+
+    auto it = candidates.find(callee->name);
+    if (it == candidates.end() || !can_inline(*it->second, call->arguments)) return;
+
+    const FunctionDeclaration& function = *it->second;
+    expression = substitute(**result_slot(function), function, call->arguments);
+    inlined++;
+
+    expanding.push_back(function.name);
+    rewrite(expression);
+    expanding.pop_back();
+}
+
+size_t Inliner::run(std::vector<StmtPtr>& program) {
+    inlined = 0;
+    candidates.clear();
+    find_candidates(program);
+    if (candidates.empty()) return 0;
+
+    for (auto& statement : program) {
+        if (!statement) continue;
+
+        auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (!function) {
+            locals = nullptr;
+            for_each_expression(*statement, [&](ExprPtr& expression) { rewrite(expression); });
+            continue;
+        }
+        if (!function->body) continue; // lazy: no nodes to rewrite yet
+
+        std::unordered_set<std::string> names = local_names(*function);
+        locals = &names;
+        expanding.push_back(function->name);
+        for_each_expression(*function, [&](ExprPtr& expression) { rewrite(expression); });
+        expanding.pop_back();
+        locals = nullptr;
+    }
+    return inlined;
+}
@@ -0,0 +1,129 @@
+#include "passes/LoopInvariant.hpp"
+#include <ostream>
+#include <unordered_map>
+#include "passes/AstUtil.hpp"
+
+namespace {
+
+// What one loop can change, gathered over the whole loop statement.
+struct LoopEffects {
+    std::unordered_set<std::string> written;
+    bool calls = false;
+
+    void add(Expression& expression) {
+        if (auto* assign = dynamic_cast<AssignExpression*>(&expression)) written.insert(assign->name);
+        if (dynamic_cast<CallExpression*>(&expression)) calls = true;
+        for_each_child(expression, [&](ExprPtr& child) { add(*child); });
+    }
+
+    void add(Statement& statement) {
+        if (auto* variable = dynamic_cast<VariableDeclaration*>(&statement)) {
+            written.insert(variable->name);
+        } else if (auto* loop = dynamic_cast<ParallelForStatement*>(&statement)) {
+            written.insert(loop->variable);
+            if (!loop->target.empty()) written.insert(loop->target);
+        }
+        for_each_child(statement, [&](StmtPtr& child) { add(*child); });
+    }
+};
+
+} // namespace
+
+void LoopInvariant::hoist(StmtPtr& loop) {
+    // Slots evaluated on every iteration, and what the loop may change.
+    std::vector<ExprPtr*> slots;
+    LoopEffects effects;
+    Statement* body = nullptr;
+    const char* kind = "";
+
+    if (auto* whileLoop = dynamic_cast<WhileStatement*>(loop.get())) {
+        slots.push_back(&whileLoop->condition);
+        body = whileLoop->body.get();
+        kind = "while";
+    } else if (auto* forLoop = dynamic_cast<ForStatement*>(loop.get())) {
+        slots.push_back(&forLoop->condition);
+        slots.push_back(&forLoop->increment);
+        if (forLoop->initializer) effects.add(*forLoop->initializer);
+        body = forLoop->body.get();
+        kind = "for";
+    } else if (auto* parallelLoop = dynamic_cast<ParallelForStatement*>(loop.get())) {
+        body = parallelLoop->body.get();
+        kind = "parallel for";
+    } else {
+        return;
+    }
+
+    effects.add(*loop);
+    for_each_expression(*loop, [&](ExprPtr& expression) { effects.add(*expression); });
+    if (body) for_each_expression(*body, [&](ExprPtr& expression) { slots.push_back(&expression); });
+
+    auto invariant = [&](const Expression& expression) {
+        if (!is_pure(expression)) return false;
+
+        std::unordered_set<std::string> names;
+        collect_names(const_cast<Expression&>(expression), names);
+        for (const auto& name : names) {
+            if (effects.written.count(name)) return false;
+            if (effects.calls && !locals->count(name)) return false;
+        }
+        return true;
+    };
+
+    // Identical invariants in one loop share a temporary.
+    std::unordered_map<std::string, std::string> temporaryFor;
+    std::vector<StmtPtr> hoistedLets;
+
+    std::function<void(ExprPtr&)> replace = [&](ExprPtr& expression) {
+        bool leaf = dynamic_cast<LiteralExpression*>(expression.get()) || dynamic_cast<VariableExpression*>(expression.get());
+        if (leaf) return;
+        if (!invariant(*expression)) {
+            for_each_child(*expression, replace);
+            return;
+        }
+
+        std::string source = to_source(*expression);
+        auto it = temporaryFor.find(source);
+        if (it == temporaryFor.end()) {
+            std::string name = "__licm" + std::to_string(temporaries++);
+            if (report) {
+                *report << "licm: hoisted " << source << " out of " << kind << " loop in "
+                        << function->name << " as " << name << "\n";
+            }
+            hoistedLets.push_back(std::make_unique<VariableDeclaration>(name, std::move(expression)));
+            it = temporaryFor.emplace(source, name).first;
+            hoisted++;
+        }
+        expression = std::make_unique<VariableExpression>(it->second);
+    };
+
+    for (ExprPtr* slot : slots) {
+        if (*slot) replace(*slot);
+    }
+    if (hoistedLets.empty()) return;
+
+    hoistedLets.push_back(std::move(loop));
+    loop = std::make_unique<BlockStatement>(std::move(hoistedLets));
+}
+
+// Children first, so inner loops hoist into the outer loop's body and the
+// outer loop can then hoist those temporaries again.
+void LoopInvariant::visit(StmtPtr& statement) {
+    for_each_child(*statement, [&](StmtPtr& child) { visit(child); });
+    hoist(statement);
+}
+
+size_t LoopInvariant::run(std::vector<StmtPtr>& program) {
+    hoisted = 0;
+    for (auto& statement : program) {
+        auto* declaration = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (!declaration || !declaration->body) continue; // lazy bodies have no nodes yet
+
+        std::unordered_set<std::string> names = local_names(*declaration);
+        function = declaration;
+        locals = &names;
+        visit(declaration->body);
+    }
+    function = nullptr;
+    locals = nullptr;
+    return hoisted;
+}
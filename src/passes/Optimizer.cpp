@@ -0,0 +1,26 @@
+#include "passes/Optimizer.hpp"
+#include "Stats.hpp"
+#include "passes/CommonSubexpression.hpp"
+#include "passes/DeadCode.hpp"
+#include "passes/Inliner.hpp"
+#include "passes/LoopInvariant.hpp"
+#include "passes/Purity.hpp"
+
+void optimize(std::vector<StmtPtr>& program, const OptimizerOptions& options) {
+    STATS_PHASE(Phase::PASSES);
+
+    size_t inlined = options.inlining ? Inliner(options.inlineBudget).run(program) : 0;
+    size_t shared = options.cse ? CommonSubexpression(options.report).run(program) : 0;
+    size_t hoisted = options.licm ? LoopInvariant(options.report).run(program) : 0;
+    size_t removed = options.deadCode ? DeadCode().run(program) : 0;
+    Purity(options.report).run(program);
+
+    STATS_ADD(Counter::INLINED_CALLS, inlined);
+    STATS_ADD(Counter::COMMON_SUBEXPRESSIONS, shared);
+    STATS_ADD(Counter::HOISTED_EXPRESSIONS, hoisted);
+    STATS_ADD(Counter::DEAD_STATEMENTS, removed);
+    (void)inlined; // only read by the stats macros
+    (void)shared;
+    (void)hoisted;
+    (void)removed;
+}
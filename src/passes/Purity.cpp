@@ -0,0 +1,172 @@
+#include "passes/Purity.hpp"
+#include <ostream>
+#include "passes/AstUtil.hpp"
+
+namespace {
+
+void collect_assigned(Expression& expression, std::unordered_set<std::string>& names) {
+    if (auto* assign = dynamic_cast<AssignExpression*>(&expression)) names.insert(assign->name);
+    for_each_child(expression, [&](ExprPtr& child) { collect_assigned(*child, names); });
+}
+
+void collect_assigned(Statement& statement, std::unordered_set<std::string>& names) {
+    for_each_expression(statement, [&](ExprPtr& expression) { collect_assigned(*expression, names); });
+
+    std::function<void(Statement&)> targets = [&](Statement& nested) {
+        auto* loop = dynamic_cast<ParallelForStatement*>(&nested);
+        if (loop && !loop->target.empty()) names.insert(loop->target);
+        for_each_child(nested, [&](StmtPtr& child) { targets(*child); });
+    };
+    targets(statement);
+}
+
+// Parameters, `let`s and loop variables; unlike local_names, a parallel
+// for's reduction target is not a binding, since it may name a global.
+std::unordered_set<std::string> bound_names(FunctionDeclaration& function) {
+    std::unordered_set<std::string> names(function.parameters.begin(), function.parameters.end());
+
+    std::function<void(Statement&)> declare = [&](Statement& statement) {
+        if (auto* variable = dynamic_cast<VariableDeclaration*>(&statement)) {
+            names.insert(variable->name);
+        } else if (auto* loop = dynamic_cast<ParallelForStatement*>(&statement)) {
+            names.insert(loop->variable);
+        }
+        for_each_child(statement, [&](StmtPtr& child) { declare(*child); });
+    };
+    declare(*function.body);
+    return names;
+}
+
+} // namespace
+
+void Purity::find_globals(std::vector<StmtPtr>& program) {
+    std::unordered_map<std::string, size_t> declarations;
+    std::unordered_set<std::string> assigned;
+    lazyBodies = false;
+    for (auto& statement : program) {
+        if (!statement) continue;
+        if (auto* function = dynamic_cast<FunctionDeclaration*>(statement.get())) {
+            declarations[function->name]++;
+            if (!function->body) {
+                lazyBodies = true;
+                continue;
+            }
+        } else if (auto* variable = dynamic_cast<VariableDeclaration*>(statement.get())) {
+            declarations[variable->name]++;
+        }
+        collect_assigned(*statement, assigned);
+    }
+
+    // An unparsed body may assign any global, so none is known to be constant.
+    auto constant = [&](const std::string& name) {
+        return !lazyBodies && declarations[name] == 1 && !assigned.count(name);
+    };
+    for (auto& statement : program) {
+        if (!statement) continue;
+        if (auto* function = dynamic_cast<FunctionDeclaration*>(statement.get())) {
+            if (constant(function->name)) {
+                functions[function->name] = function;
+                continue;
+            }
+            mutableGlobals.insert(function->name);
+        } else if (auto* variable = dynamic_cast<VariableDeclaration*>(statement.get())) {
+            if (constant(variable->name)) {
+                constants.insert(variable->name);
+                continue;
+            }
+            mutableGlobals.insert(variable->name);
+        }
+    }
+}
+
+// Why `function` may not be pure given the current marks on its callees, or
+// an empty string if it is.
+std::string Purity::impurity(FunctionDeclaration& function) const {
+    if (!function.body) return "body not parsed yet";
+
+    std::unordered_set<std::string> locals = bound_names(function);
+    auto local = [&](const std::string& name) { return locals.count(name) && !mutableGlobals.count(name); };
+
+    std::string reason;
+    std::function<void(Expression&)> check = [&](Expression& expression) {
+        if (!reason.empty()) return;
+
+        if (auto* assign = dynamic_cast<AssignExpression*>(&expression)) {
+            if (!local(assign->name)) reason = "assigns " + assign->name;
+        } else if (auto* variable = dynamic_cast<VariableExpression*>(&expression)) {
+            bool known = local(variable->name) || (!mutableGlobals.count(variable->name) &&
+                (constants.count(variable->name) || functions.count(variable->name)));
+            if (!known) reason = "reads " + variable->name;
+        } else if (auto* call = dynamic_cast<CallExpression*>(&expression)) {
+            auto* callee = dynamic_cast<VariableExpression*>(call->callee.get());
+            if (!callee || locals.count(callee->name)) {
+                reason = "calls a function value";
+                return;
+            }
+            auto it = functions.find(callee->name);
+            if (it == functions.end()) {
+                reason = "calls " + callee->name;
+            } else if (!it->second->pure) {
+                reason = "calls impure " + callee->name;
+            }
+            for (auto& argument : call->arguments) check(*argument);
+            return;
+        }
+        for_each_child(expression, [&](ExprPtr& child) { check(*child); });
+    };
+    for_each_expression(*function.body, [&](ExprPtr& expression) { check(*expression); });
+
+    std::function<void(Statement&)> targets = [&](Statement& statement) {
+        auto* loop = dynamic_cast<ParallelForStatement*>(&statement);
+        if (reason.empty() && loop && !loop->target.empty() && !local(loop->target)) reason = "assigns " + loop->target;
+        for_each_child(statement, [&](StmtPtr& child) { targets(*child); });
+    };
+    targets(*function.body);
+    return reason;
+}
+
+size_t Purity::run(std::vector<StmtPtr>& program) {
+    functions.clear();
+    constants.clear();
+    mutableGlobals.clear();
+    find_globals(program);
+
+    for (auto& statement : program) {
+        if (auto* function = dynamic_cast<FunctionDeclaration*>(statement.get())) {
+            function->pure = function->body && functions.count(function->name);
+        }
+    }
+
+    // Greatest fixed point: only ever clear marks, until none changes.
+    std::unordered_map<std::string, std::string> reasons;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto& [name, function] : functions) {
+            if (!function->pure) continue;
+            std::string reason = impurity(*function);
+            if (reason.empty()) continue;
+            function->pure = false;
+            reasons[name] = reason;
+            changed = true;
+        }
+    }
+
+    size_t memoized = 0;
+    for (auto& statement : program) {
+        auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (!function || !function->memoize) continue;
+        if (function->pure) {
+            memoized++;
+            continue;
+        }
+        if (report) {
+            auto it = reasons.find(function->name);
+            std::string reason = it != reasons.end() ? it->second
+                : !function->body ? "body not parsed yet"
+                : lazyBodies ? "a body not parsed yet may reassign globals" : "redeclared or reassigned";
+            *report << "memo: " << function->name << " is not pure (" << reason << "); not memoized\n";
+        }
+    }
+    return memoized;
+}
@@ -0,0 +1,372 @@
+#include "passes/TypeInference.hpp"
+#include <ostream>
+#include <unordered_set>
+#include "passes/AstUtil.hpp"
+
+ValueType join(ValueType a, ValueType b) {
+    if (a == ValueType::UNKNOWN) return b;
+    if (b == ValueType::UNKNOWN || a == b) return a;
+    return ValueType::DYNAMIC;
+}
+
+const char* type_name(ValueType type) {
+    switch (type) {
+        case ValueType::UNKNOWN: return "unknown";
+        case ValueType::INT: return "int";
+        case ValueType::FLOAT: return "float";
+        case ValueType::STRING: return "string";
+        case ValueType::BOOL: return "bool";
+        case ValueType::NULL_VALUE: return "null";
+        case ValueType::DYNAMIC: return "dynamic";
+    }
+    return "?";
+}
+
+bool is_unboxed(ValueType type) {
+    return type == ValueType::INT || type == ValueType::FLOAT;
+}
+
+// --- Environments ---
+TypeInference::Binding* TypeInference::lookup(Environment& environment, const std::string& name) {
+    for (auto scope = environment.rbegin(); scope != environment.rend(); ++scope) {
+        auto it = scope->find(name);
+        if (it != scope->end()) return &it->second;
+    }
+    return nullptr;
+}
+
+// Joins `other` into `environment`. Both have the same scopes, since every
+// statement pops what it pushes.
+bool TypeInference::merge(Environment& environment, const Environment& other) {
+    bool grew = false;
+    for (size_t i = 0; i < environment.size() && i < other.size(); i++) {
+        for (auto& entry : environment[i]) {
+            auto it = other[i].find(entry.first);
+            if (it == other[i].end()) continue;
+
+            ValueType joined = join(entry.second.type, it->second.type);
+            grew = grew || joined != entry.second.type;
+            entry.second.type = joined;
+        }
+    }
+    return grew;
+}
+
+bool TypeInference::widen(ValueType& target, ValueType type) {
+    ValueType joined = join(target, type);
+    if (joined == target) return false;
+    target = joined;
+    return true;
+}
+
+void TypeInference::assign(const std::string& name, ValueType type, Environment& environment) {
+    if (Binding* binding = lookup(environment, name)) {
+        binding->type = type;
+        if (binding->declaration) widen(binding->declaration->type, type);
+        return;
+    }
+
+    auto global = globals.find(name);
+    if (global != globals.end() && widen(global->second->type, type)) changed = true;
+}
+
+// --- Expressions ---
+static bool is_numeric(ValueType type) {
+    return type == ValueType::INT || type == ValueType::FLOAT;
+}
+
+static ValueType arithmetic(TokenType op, ValueType left, ValueType right) {
+    if (left == ValueType::UNKNOWN || right == ValueType::UNKNOWN) return ValueType::UNKNOWN;
+
+    if (is_numeric(left) && is_numeric(right)) {
+        // Integer division semantics are the runtime's call; leave them boxed.
+        if (op == TokenType::DIVIDE && left == ValueType::INT && right == ValueType::INT) return ValueType::DYNAMIC;
+        return left == ValueType::FLOAT || right == ValueType::FLOAT ? ValueType::FLOAT : ValueType::INT;
+    }
+    if (op == TokenType::ADD && left == ValueType::STRING && right == ValueType::STRING) return ValueType::STRING;
+    return ValueType::DYNAMIC;
+}
+
+ValueType TypeInference::infer(Expression& expression, Environment& environment) {
+    ValueType type = ValueType::DYNAMIC;
+
+    if (auto* literal = dynamic_cast<LiteralExpression*>(&expression)) {
+        switch (literal->literal.type) {
+            case TokenType::INT_LITERAL: type = ValueType::INT; break;
+            case TokenType::FLOAT_LITERAL: type = ValueType::FLOAT; break;
+            case TokenType::STRING_LITERAL: type = ValueType::STRING; break;
+            case TokenType::BOOLEAN_LITERAL: type = ValueType::BOOL; break;
+            case TokenType::NULL_LITERAL: type = ValueType::NULL_VALUE; break;
+            default: break;
+        }
+    } else if (auto* variable = dynamic_cast<VariableExpression*>(&expression)) {
+        auto global = globals.find(variable->name);
+        if (Binding* binding = lookup(environment, variable->name)) {
+            type = binding->type;
+        } else if (global != globals.end()) {
+            type = global->second->type;
+        }
+    } else if (auto* assignment = dynamic_cast<AssignExpression*>(&expression)) {
+        type = infer(*assignment->value, environment);
+        assign(assignment->name, type, environment);
+    } else if (auto* unary = dynamic_cast<UnaryExpression*>(&expression)) {
+        ValueType right = infer(*unary->right, environment);
+        if (unary->op == TokenType::NOT) {
+            type = ValueType::BOOL;
+        } else if (right == ValueType::UNKNOWN || is_numeric(right)) {
+            type = right;
+        }
+    } else if (auto* binary = dynamic_cast<BinaryExpression*>(&expression)) {
+        ValueType left = infer(*binary->left, environment);
+        switch (binary->op) {
+            case TokenType::AND:
+            case TokenType::OR: {
+                // The right operand may not run, so its assignments may not happen.
+                Environment skipped = environment;
+                infer(*binary->right, environment);
+                merge(environment, skipped);
+                type = ValueType::BOOL;
+                break;
+            }
+            case TokenType::EQUAL:
+            case TokenType::NOT_EQUAL:
+            case TokenType::LESS_THAN:
+            case TokenType::LESS_THAN_OR_EQUAL:
+            case TokenType::GREATER_THAN:
+            case TokenType::GREATER_THAN_OR_EQUAL:
+                infer(*binary->right, environment);
+                type = ValueType::BOOL;
+                break;
+            default:
+                type = arithmetic(binary->op, left, infer(*binary->right, environment));
+        }
+    } else if (auto* call = dynamic_cast<CallExpression*>(&expression)) {
+        std::vector<ValueType> arguments;
+        for (auto& argument : call->arguments) arguments.push_back(infer(*argument, environment));
+
+        auto* callee = dynamic_cast<VariableExpression*>(call->callee.get());
+        auto function = callee && !lookup(environment, callee->name) ? functions.find(callee->name) : functions.end();
+        if (function != functions.end()) {
+            FunctionDeclaration& target = *function->second;
+            bool arityMatches = arguments.size() == target.parameterTypes.size();
+            for (size_t i = 0; i < target.parameterTypes.size(); i++) {
+                ValueType argument = arityMatches ? arguments[i] : ValueType::DYNAMIC;
+                if (widen(target.parameterTypes[i], argument)) changed = true;
+            }
+            callee->type = ValueType::DYNAMIC;
+            type = target.returnType;
+        } else {
+            infer(*call->callee, environment);
+        }
+    }
+
+    expression.type = type;
+    return type;
+}
+
+// --- Statements ---
+void TypeInference::analyse_scoped(Statement& statement, Environment& environment) {
+    environment.emplace_back();
+    analyse(statement, environment);
+    environment.pop_back();
+}
+
+// Iterates until the state at the loop head stops growing, so the last pass
+// annotates the body with types that hold on every iteration.
+void TypeInference::analyse_loop(Expression* condition, Statement* body, Expression* increment, Environment& environment) {
+    while (true) {
+        Environment head = environment;
+        if (condition) infer(*condition, environment);
+        if (body) analyse_scoped(*body, environment);
+        if (increment) infer(*increment, environment);
+
+        bool grew = merge(head, environment);
+        environment = std::move(head);
+        if (!grew) break;
+    }
+
+    // The evaluation that exits the loop.
+    if (condition) infer(*condition, environment);
+}
+
+void TypeInference::analyse(Statement& statement, Environment& environment) {
+    if (auto* expression = dynamic_cast<ExpressionStatement*>(&statement)) {
+        infer(*expression->expression, environment);
+    } else if (auto* variable = dynamic_cast<VariableDeclaration*>(&statement)) {
+        ValueType type = variable->initializer ? infer(*variable->initializer, environment) : ValueType::NULL_VALUE;
+        environment.back()[variable->name] = Binding{type, variable};
+        widen(variable->type, type);
+    } else if (auto* block = dynamic_cast<BlockStatement*>(&statement)) {
+        environment.emplace_back();
+        for (auto& child : block->statements) {
+            if (child) analyse(*child, environment);
+        }
+        environment.pop_back();
+    } else if (auto* branch = dynamic_cast<IfStatement*>(&statement)) {
+        infer(*branch->condition, environment);
+        Environment otherwise = environment;
+        if (branch->thenBranch) analyse_scoped(*branch->thenBranch, environment);
+        if (branch->elseBranch) analyse_scoped(*branch->elseBranch, otherwise);
+        merge(environment, otherwise);
+    } else if (auto* loop = dynamic_cast<WhileStatement*>(&statement)) {
+        analyse_loop(loop->condition.get(), loop->body.get(), nullptr, environment);
+    } else if (auto* loop = dynamic_cast<ForStatement*>(&statement)) {
+        environment.emplace_back();
+        if (loop->initializer) analyse(*loop->initializer, environment);
+        analyse_loop(loop->condition.get(), loop->body.get(), loop->increment.get(), environment);
+        environment.pop_back();
+    } else if (auto* loop = dynamic_cast<ParallelForStatement*>(&statement)) {
+        analyse_parallel(*loop, environment);
+    } else if (auto* ret = dynamic_cast<ReturnStatement*>(&statement)) {
+        ValueType type = ret->value ? infer(*ret->value, environment) : ValueType::NULL_VALUE;
+        if (current && widen(current->returnType, type)) changed = true;
+    }
+}
+
+// Ranges bind an int loop variable; list elements are not tracked. The
+// target is a fresh per-iteration contribution inside the body, and the
+// reduced result is assigned to the enclosing variable after the loop.
+void TypeInference::analyse_parallel(ParallelForStatement& loop, Environment& environment) {
+    ValueType iterable = infer(*loop.iterable, environment);
+    ValueType element = iterable == ValueType::INT || iterable == ValueType::UNKNOWN ? iterable : ValueType::DYNAMIC;
+
+    ValueType contribution = ValueType::UNKNOWN;
+    while (true) {
+        Environment head = environment;
+        environment.emplace_back();
+        environment.back()[loop.variable] = Binding{element, nullptr};
+        if (!loop.target.empty()) environment.back()[loop.target] = Binding{ValueType::UNKNOWN, nullptr};
+        if (loop.body) analyse_scoped(*loop.body, environment);
+        if (!loop.target.empty()) contribution = join(contribution, environment.back()[loop.target].type);
+        environment.pop_back();
+
+        bool grew = merge(head, environment);
+        environment = std::move(head);
+        if (!grew) break;
+    }
+
+    if (loop.reduction == Reduction::NONE) return;
+    ValueType result = loop.reduction == Reduction::APPEND ? ValueType::DYNAMIC : contribution;
+    if (loop.reduction == Reduction::SUM && !is_numeric(result) && result != ValueType::UNKNOWN) result = ValueType::DYNAMIC;
+    assign(loop.target, result, environment);
+}
+
+// --- Whole program ---
+// A name read anywhere but in callee position escapes: the value can be
+// called later with arguments no call site here shows.
+static void collect_calls(Expression& expression, std::unordered_set<std::string>& called,
+                          std::unordered_set<std::string>& assigned, std::unordered_set<std::string>& escaped) {
+    if (auto* call = dynamic_cast<CallExpression*>(&expression)) {
+        if (auto* callee = dynamic_cast<VariableExpression*>(call->callee.get())) {
+            called.insert(callee->name);
+        } else {
+            collect_calls(*call->callee, called, assigned, escaped);
+        }
+        for (auto& argument : call->arguments) collect_calls(*argument, called, assigned, escaped);
+        return;
+    }
+
+    if (auto* variable = dynamic_cast<VariableExpression*>(&expression)) {
+        escaped.insert(variable->name);
+    } else if (auto* assignment = dynamic_cast<AssignExpression*>(&expression)) {
+        assigned.insert(assignment->name);
+    }
+    for_each_child(expression, [&](ExprPtr& child) { collect_calls(*child, called, assigned, escaped); });
+}
+
+void TypeInference::run(std::vector<StmtPtr>& program) {
+    std::unordered_map<std::string, size_t> declarations;
+    std::unordered_set<std::string> called;
+    std::unordered_set<std::string> assigned;
+    std::unordered_set<std::string> escaped;
+    for (auto& statement : program) {
+        if (!statement) continue;
+        if (auto* function = dynamic_cast<FunctionDeclaration*>(statement.get())) {
+            declarations[function->name]++;
+        } else if (auto* variable = dynamic_cast<VariableDeclaration*>(statement.get())) {
+            declarations[variable->name]++;
+        }
+        for_each_expression(*statement, [&](ExprPtr& expression) { collect_calls(*expression, called, assigned, escaped); });
+    }
+
+    // Only uniquely named, never reassigned functions can be resolved at a
+    // call site; everything else keeps dynamic signatures.
+    functions.clear();
+    globals.clear();
+    for (auto& statement : program) {
+        if (auto* function = dynamic_cast<FunctionDeclaration*>(statement.get())) {
+            bool resolvable = declarations[function->name] == 1 && !assigned.count(function->name);
+            bool analysed = resolvable && called.count(function->name) && !escaped.count(function->name) && function->body;
+            function->parameterTypes.assign(function->parameters.size(), analysed ? ValueType::UNKNOWN : ValueType::DYNAMIC);
+            function->returnType = function->body ? ValueType::UNKNOWN : ValueType::DYNAMIC;
+            if (resolvable) functions[function->name] = function;
+        } else if (auto* variable = dynamic_cast<VariableDeclaration*>(statement.get())) {
+            variable->type = ValueType::UNKNOWN;
+            if (declarations[variable->name] == 1) globals[variable->name] = variable;
+        }
+    }
+
+    do {
+        changed = false;
+        for (auto& statement : program) {
+            if (!statement) continue;
+
+            Environment environment(1);
+            if (auto* variable = dynamic_cast<VariableDeclaration*>(statement.get())) {
+                ValueType type = variable->initializer ? infer(*variable->initializer, environment) : ValueType::NULL_VALUE;
+                if (widen(variable->type, type)) changed = true;
+                continue;
+            }
+
+            // Top-level code runs too: its assignments widen globals and its
+            // calls widen parameters.
+            auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+            if (!function) {
+                analyse(*statement, environment);
+                continue;
+            }
+            if (!function->body) continue;
+
+            current = function;
+            for (size_t i = 0; i < function->parameters.size(); i++) {
+                environment.back()[function->parameters[i]] = Binding{function->parameterTypes[i], nullptr};
+            }
+            analyse(*function->body, environment);
+
+            // Falling off the end returns null.
+            auto* block = dynamic_cast<BlockStatement*>(function->body.get());
+            bool returns = block && !block->statements.empty() && dynamic_cast<ReturnStatement*>(block->statements.back().get());
+            if (!returns && widen(function->returnType, ValueType::NULL_VALUE)) changed = true;
+        }
+        current = nullptr;
+    } while (changed);
+}
+
+// --- Dump ---
+static void dump_locals(Statement& statement, std::ostream& out) {
+    if (auto* variable = dynamic_cast<VariableDeclaration*>(&statement)) {
+        out << "    let " << variable->name << ": " << type_name(variable->type)
+            << (is_unboxed(variable->type) ? " (unboxed)" : "") << "\n";
+    }
+    for_each_child(statement, [&](StmtPtr& child) { dump_locals(*child, out); });
+}
+
+void dump_types(const std::vector<StmtPtr>& program, std::ostream& out) {
+    for (const auto& statement : program) {
+        if (auto* variable = dynamic_cast<VariableDeclaration*>(statement.get())) {
+            out << "let " << variable->name << ": " << type_name(variable->type) << "\n";
+            continue;
+        }
+
+        auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (!function) continue;
+
+        out << "function " << function->name << "(";
+        for (size_t i = 0; i < function->parameters.size(); i++) {
+            ValueType type = i < function->parameterTypes.size() ? function->parameterTypes[i] : ValueType::UNKNOWN;
+            out << (i > 0 ? ", " : "") << function->parameters[i] << ": " << type_name(type);
+        }
+        out << ") -> " << type_name(function->returnType) << (function->body ? "" : " (lazy)") << "\n";
+        if (function->body) dump_locals(*function->body, out);
+    }
+}
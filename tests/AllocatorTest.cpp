@@ -0,0 +1,162 @@
+// Arena, pool and tracking allocators, budgets and allocator scopes.
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "Allocator.hpp"
+#include "Lexer.hpp"
+#include "Parser.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+// An upstream that refuses every request.
+class FailingAllocator : public Allocator {
+public:
+    void* allocate(size_t, size_t) override { throw std::bad_alloc(); }
+    void deallocate(void*, size_t, size_t) noexcept override {}
+};
+
+static void arenas() {
+    TrackingAllocator upstream;
+    {
+        ArenaAllocator arena(upstream, 1024);
+        void* a = arena.allocate(10);
+        void* b = arena.allocate(24, 64);
+        check((uintptr_t)b % 64 == 0, "an arena honours the requested alignment");
+        check((char*)b >= (char*)a + 10, "arena allocations do not overlap");
+        check(arena.used() == 34, "used() counts the requested bytes");
+        check(upstream.allocations(Phase::READ) == 1, "small requests share one block");
+
+        arena.allocate(4096);
+        check(upstream.allocations(Phase::READ) == 2, "an oversized request gets a block of its own");
+
+        arena.reset();
+        check(upstream.live() == 0 && arena.used() == 0, "reset() returns every block");
+        arena.allocate(10);
+    }
+    check(upstream.live() == 0, "the destructor returns every block");
+}
+
+static void pools() {
+    TrackingAllocator upstream;
+    {
+        PoolAllocator pool(upstream, 1024);
+        void* a = pool.allocate(30);
+        void* b = pool.allocate(30);
+        check(a != b, "live slots are distinct");
+        pool.deallocate(a, 30);
+        check(pool.allocate(40) != a, "another size class does not take a freed slot");
+        check(pool.allocate(20) == a, "its own size class reuses it");
+        check(upstream.allocations(Phase::READ) == 1, "slots are carved from one chunk");
+
+        void* big = pool.allocate(1000);
+        check(upstream.allocations(Phase::READ) == 2, "a request above the largest class goes upstream");
+        pool.deallocate(big, 1000);
+        check(upstream.live() == 1024, "and is returned upstream when freed");
+    }
+    check(upstream.live() == 0, "the destructor returns every chunk");
+}
+
+static void budgets() {
+    TrackingAllocator tracker(default_allocator(), 100);
+    void* first = tracker.allocate(60);
+
+    bool exceeded = false;
+    try {
+        tracker.allocate(60);
+    } catch (const MemoryBudgetExceeded& e) {
+        exceeded = e.requested == 60 && e.live == 60 && e.budget == 100;
+    }
+    check(exceeded, "a request past the budget throws with the numbers");
+    check(tracker.live() == 60, "a refused request is rolled back from live()");
+    tracker.deallocate(first, 60);
+    check(tracker.live() == 0 && tracker.peak() == 60, "live() falls on free, peak() does not");
+
+    FailingAllocator failing;
+    TrackingAllocator over(failing);
+    bool threw = false;
+    try {
+        over.allocate(32);
+    } catch (const std::bad_alloc&) {
+        threw = true;
+    }
+    check(threw && over.live() == 0, "an upstream failure is rolled back from live()");
+    check(over.allocations(Phase::READ) == 0, "and is not counted");
+}
+
+static void phases() {
+    TrackingAllocator tracker;
+    std::vector<void*> blocks;
+    blocks.push_back(tracker.allocate(8));
+    {
+        TrackingAllocator::PhaseScope parse(tracker, Phase::PARSE);
+        blocks.push_back(tracker.allocate(16));
+        blocks.push_back(tracker.allocate(16));
+        {
+            TrackingAllocator::PhaseScope passes(tracker, Phase::PASSES);
+            blocks.push_back(tracker.allocate(32));
+        }
+        blocks.push_back(tracker.allocate(16));
+    }
+    blocks.push_back(tracker.allocate(8));
+
+    check(tracker.allocations(Phase::READ) == 2 && tracker.bytes(Phase::READ) == 16, "allocations before and after go to READ");
+    check(tracker.allocations(Phase::PARSE) == 3 && tracker.bytes(Phase::PARSE) == 48, "a phase scope counts its allocations");
+    check(tracker.allocations(Phase::PASSES) == 1 && tracker.bytes(Phase::PASSES) == 32, "nested scopes restore the outer phase");
+
+    size_t sizes[] = {8, 16, 16, 32, 16, 8};
+    for (size_t i = 0; i < blocks.size(); i++) tracker.deallocate(blocks[i], sizes[i]);
+    check(tracker.live() == 0 && tracker.peak() == 96, "live and peak bytes across phases");
+}
+
+static void scopes() {
+    std::vector<Token> tokens = lex("function f(x) { return x + 1; } let a = f(2);");
+    TrackingAllocator outer;
+    TrackingAllocator inner;
+    std::vector<StmtPtr> program;
+    {
+        AllocatorScope scope(outer);
+        check(&current_allocator() == &outer, "a scope makes its allocator current");
+        {
+            AllocatorScope nested(inner);
+            check(&current_allocator() == &inner, "scopes nest");
+        }
+        check(&current_allocator() == &outer, "an inner scope restores the outer allocator");
+        program = Parser(tokens).parse();
+    }
+    check(&current_allocator() == &default_allocator(), "the last scope restores the default");
+    check(outer.live() > 0 && inner.live() == 0, "nodes come from the allocator current when they were made");
+
+    program.clear();
+    check(outer.live() == 0, "nodes go back to their allocator after its scope ended");
+}
+
+int main() {
+    arenas();
+    pools();
+    budgets();
+    phases();
+    scopes();
+
+    if (failures) return 1;
+    std::cout << "allocator: ok\n";
+    return 0;
+}
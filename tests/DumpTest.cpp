@@ -0,0 +1,190 @@
+// Binary token and AST dumps written through OutputBuffer, mapped back with
+// DumpImage and checked record by record.
+#include <fcntl.h>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "Dump.hpp"
+#include "Parser.hpp"
+#include "bench/Generator.hpp"
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+template <typename Write>
+static void write_dump(const std::string& path, Write write) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw std::runtime_error("Could not create " + path);
+    {
+        OutputBuffer out(fd);
+        write(out);
+        out.flush();
+    }
+    close(fd);
+}
+
+static std::string text(const DumpImage& image, StringRef ref) {
+    return std::string(image.strings().substr(ref.offset, ref.length));
+}
+
+// Walks the subtree at `index` by the child counts Dump.hpp documents and
+// returns the index past it; every `end` must agree.
+static uint32_t walk(const DumpImage& image, uint32_t index, bool& consistent) {
+    if (index >= image.size()) {
+        consistent = false;
+        return index;
+    }
+    const AstRecord& node = image.nodes()[index];
+    uint32_t children = 0;
+    switch (node.kind) {
+        case AstKind::EMPTY:
+        case AstKind::LITERAL:
+        case AstKind::VARIABLE:
+        case AstKind::IMPORT:
+        case AstKind::PARAMETER: children = 0; break;
+        case AstKind::ASSIGN:
+        case AstKind::UNARY:
+        case AstKind::EXPRESSION:
+        case AstKind::LET:
+        case AstKind::RETURN: children = 1; break;
+        case AstKind::BINARY:
+        case AstKind::WHILE:
+        case AstKind::PARALLEL_FOR: children = 2; break;
+        case AstKind::IF: children = 3; break;
+        case AstKind::FOR: children = 4; break;
+        case AstKind::CALL:
+        case AstKind::FUNCTION: children = node.count + 1; break;
+        case AstKind::BLOCK: children = node.count; break;
+    }
+
+    uint32_t next = index + 1;
+    for (uint32_t i = 0; i < children && consistent; i++) next = walk(image, next, consistent);
+    if (node.end != next) consistent = false;
+    return next;
+}
+
+static void tokens(const std::string& path) {
+    std::string source = "let a = \"x\";\nfunction f(b) { return b + 1; }\n";
+    std::vector<Token> lexed = lex(source);
+    write_dump(path, [&](OutputBuffer& out) { dump_tokens_binary(lexed, out); });
+
+    DumpImage image(path, DumpImage::Kind::TOKENS);
+    check(image.size() == lexed.size(), "one record per token");
+    bool same = image.size() == lexed.size();
+    for (size_t i = 0; same && i < lexed.size(); i++) {
+        Token token = from_record(image.tokens()[i], image.strings());
+        same = token.type == lexed[i].type && token.value == lexed[i].value && token.line == lexed[i].line &&
+               token.column == lexed[i].column && token.offset == lexed[i].offset;
+    }
+    check(same, "token records read back as the lexed tokens");
+
+    bool rejected = false;
+    try {
+        DumpImage wrong(path, DumpImage::Kind::AST);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    check(rejected, "a token dump is not opened as an AST dump");
+}
+
+static void small_tree(const std::string& path) {
+    // The last ';' is an empty statement.
+    std::vector<Token> lexed = lex("memo function f(a, b) { return a + b; } let x = f(1, 2); ;");
+    std::vector<StmtPtr> program = Parser(lexed).parse();
+    write_dump(path, [&](OutputBuffer& out) { dump_ast_binary(program, out); });
+
+    DumpImage image(path, DumpImage::Kind::AST);
+    struct Expected {
+        AstKind kind;
+        uint32_t end;
+        std::string text;
+    };
+    const Expected expected[] = {
+        {AstKind::FUNCTION, 8, "f"}, {AstKind::PARAMETER, 2, "a"}, {AstKind::PARAMETER, 3, "b"},
+        {AstKind::BLOCK, 8, ""},     {AstKind::RETURN, 8, ""},     {AstKind::BINARY, 8, ""},
+        {AstKind::VARIABLE, 7, "a"}, {AstKind::VARIABLE, 8, "b"},  {AstKind::LET, 13, "x"},
+        {AstKind::CALL, 13, ""},     {AstKind::VARIABLE, 11, "f"}, {AstKind::LITERAL, 12, "1"},
+        {AstKind::LITERAL, 13, "2"}, {AstKind::EMPTY, 14, ""},
+    };
+    size_t count = sizeof(expected) / sizeof(expected[0]);
+    check(image.size() == count, "one record per node: " + std::to_string(image.size()));
+
+    for (size_t i = 0; i < count && i < image.size(); i++) {
+        const AstRecord& node = image.nodes()[i];
+        bool matches = node.kind == expected[i].kind && node.end == expected[i].end && text(image, node.text) == expected[i].text;
+        check(matches, "record " + std::to_string(i) + " kind " + std::to_string((int)node.kind) + " end " +
+                           std::to_string(node.end) + " '" + text(image, node.text) + "'");
+    }
+    if (image.size() == count) {
+        check(image.nodes()[0].count == 2 && image.nodes()[0].flags == AST_MEMO, "function parameter count and memo flag");
+        check(image.nodes()[3].count == 1 && image.nodes()[9].count == 2, "block and call child counts");
+        check(image.nodes()[5].op == (uint16_t)TokenType::ADD, "binary operator");
+    }
+}
+
+// Every subtree of a generated program, eager and lazy, ends where its
+// children do.
+static void generated(const std::string& path) {
+    for (Shape shape : {Shape::NESTED, Shape::FUNCTIONS}) {
+        std::vector<Token> lexed = lex(Generator(shape, 11).generate(64 * 1024));
+        for (bool lazy : {false, true}) {
+            const std::string label = std::string(shape_name(shape)) + (lazy ? " (lazy)" : "");
+            std::vector<StmtPtr> program = Parser(lexed, lazy).parse();
+            write_dump(path, [&](OutputBuffer& out) { dump_ast_binary(program, out); });
+
+            DumpImage image(path, DumpImage::Kind::AST);
+            bool consistent = true;
+            uint32_t next = 0;
+            size_t statements = 0;
+            while (consistent && next < image.size()) {
+                next = walk(image, next, consistent);
+                statements++;
+            }
+            check(consistent && next == image.size(), label + ": end indices nest");
+            check(statements == program.size(), label + ": one top-level subtree per statement");
+
+            bool flagged = true;
+            for (uint32_t i = 0; i < image.size(); i++) {
+                const AstRecord& node = image.nodes()[i];
+                if (node.kind != AstKind::FUNCTION) continue;
+                bool empty = image.nodes()[i + 1 + node.count].kind == AstKind::EMPTY;
+                flagged = flagged && ((node.flags & AST_LAZY) != 0) == lazy && empty == lazy;
+            }
+            check(flagged, label + ": lazy functions are flagged and have an EMPTY body");
+        }
+    }
+}
+
+int main() {
+    std::string path = (fs::temp_directory_path() / ("agscript_dump_" + std::to_string(getpid()) + ".bin")).string();
+    tokens(path);
+    small_tree(path);
+    generated(path);
+    fs::remove(path);
+
+    if (failures) return 1;
+    std::cout << "dump: ok\n";
+    return 0;
+}
@@ -0,0 +1,164 @@
+// EventLoop against local socketpairs and temp files only.
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "EventLoop.hpp"
+#include "WorkerPool.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::string temp_path() {
+    char path[] = "/tmp/agscript-eventloop-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) close(fd);
+    return path;
+}
+
+static void files(WorkerPool* pool) {
+    const std::string label = pool ? "pool: " : "inline: ";
+    EventLoop loop(pool);
+    std::string path = temp_path();
+    std::string contents(200000, 'x');
+    contents += "end";
+
+    bool read = false;
+    loop.write_file(path, contents, [&](EventLoop::Result written) {
+        check(written.error == 0, label + "write_file succeeds");
+        loop.read_file(path, [&](EventLoop::Result result) {
+            check(result.error == 0, label + "read_file succeeds");
+            check(result.data == contents, label + "read_file returns what was written");
+            read = true;
+        });
+    });
+
+    bool missing = false;
+    loop.read_file(path + ".missing", [&](EventLoop::Result result) {
+        check(result.error == ENOENT, label + "read_file of a missing file reports ENOENT");
+        missing = true;
+    });
+
+    loop.run();
+    check(read && missing, label + "every file completion ran");
+    check(loop.in_flight() == 0, label + "nothing left in flight");
+    unlink(path.c_str());
+}
+
+static void sockets() {
+    EventLoop loop;
+    std::vector<int> pairs;
+    std::vector<std::string> received(64);
+
+    // Many reads in flight at once, answered in reverse order.
+    for (size_t i = 0; i < received.size(); i++) {
+        int fds[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+        pairs.push_back(fds[0]);
+        pairs.push_back(fds[1]);
+        loop.read(fds[0], 64, [&received, i](EventLoop::Result result) { received[i] = result.data; });
+    }
+
+    bool busy = false;
+    loop.read(pairs[0], 64, [&](EventLoop::Result result) { busy = result.error == EBUSY; });
+
+    for (size_t i = received.size(); i-- > 0;) {
+        std::string message = "message " + std::to_string(i);
+        check(write(pairs[2 * i + 1], message.data(), message.size()) == (ssize_t)message.size(), "socket write");
+    }
+
+    loop.run();
+    check(busy, "a second read on the same fd fails with EBUSY");
+    for (size_t i = 0; i < received.size(); i++) {
+        check(received[i] == "message " + std::to_string(i), "socket " + std::to_string(i) + " got its own message");
+    }
+
+    // Closing the writer completes a read with empty data.
+    bool eof = false;
+    close(pairs[3]);
+    loop.read(pairs[2], 64, [&](EventLoop::Result result) { eof = result.error == 0 && result.data.empty(); });
+    loop.run();
+    check(eof, "read at end of stream completes empty");
+
+    for (size_t i = 0; i < pairs.size(); i++) {
+        if (i != 3) close(pairs[i]);
+    }
+}
+
+static void timers() {
+    EventLoop loop;
+    std::vector<int> order;
+    auto start = std::chrono::steady_clock::now();
+    loop.sleep(30, [&](EventLoop::Result) { order.push_back(30); });
+    loop.sleep(10, [&](EventLoop::Result) { order.push_back(10); });
+    loop.sleep(10, [&](EventLoop::Result) { order.push_back(11); });
+    loop.sleep(0, [&](EventLoop::Result) { order.push_back(0); });
+    loop.run();
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    check(order == std::vector<int>{0, 10, 11, 30}, "sleeps complete by deadline, ties in submission order");
+    check(elapsed >= std::chrono::milliseconds(30), "the longest sleep was waited out");
+}
+
+// Destroying a loop with file operations still on the pool must neither run
+// their completions nor let the jobs post into the freed loop.
+static void destroy_with_offloads() {
+    WorkerPool pool(2);
+    std::string path = temp_path();
+    bool ran = false;
+    for (int round = 0; round < 20; round++) {
+        EventLoop loop(&pool);
+        for (int i = 0; i < 50; i++) {
+            loop.write_file(path, "data", [&](EventLoop::Result) { ran = true; });
+        }
+    }
+    pool.wait();
+    check(!ran, "completions of a destroyed loop never run");
+    unlink(path.c_str());
+}
+
+// A job on a one-thread pool that destroys its loop holds the only worker,
+// so the file operations it queued can never start; the destructor must not
+// wait for them.
+static void destroy_from_own_pool() {
+    WorkerPool pool(1);
+    std::string path = temp_path();
+    bool ran = false;
+    bool destroyed = false;
+    pool.submit([&]() {
+        {
+            EventLoop loop(&pool);
+            for (int i = 0; i < 10; i++) {
+                loop.write_file(path, "data", [&](EventLoop::Result) { ran = true; });
+            }
+        }
+        destroyed = true;
+    });
+    pool.wait();
+    check(destroyed && !ran, "a loop destroyed from a job on its one-thread pool");
+    unlink(path.c_str());
+}
+
+int main() {
+    WorkerPool pool(2);
+    files(&pool);
+    files(nullptr);
+    sockets();
+    timers();
+    destroy_with_offloads();
+    destroy_from_own_pool();
+
+    if (failures) return 1;
+    std::cout << "event loop: ok\n";
+    return 0;
+}
@@ -0,0 +1,217 @@
+// Incremental re-lexing and re-parsing against a fresh lex and parse of the
+// edited text.
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "Dump.hpp"
+#include "Incremental.hpp"
+#include "bench/Generator.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+static std::string describe(const std::vector<Token>& tokens) {
+    std::string out;
+    for (const Token& token : tokens) {
+        out += std::to_string((int)token.type) + " '" + token.value + "' " + std::to_string(token.line) + ":" +
+               std::to_string(token.column) + "@" + std::to_string(token.offset) + "\n";
+    }
+    return out;
+}
+
+static std::string ast_dump(const std::vector<StmtPtr>& program) {
+    FILE* file = std::tmpfile();
+    {
+        OutputBuffer out(fileno(file));
+        dump_ast_binary(program, out);
+        out.flush();
+    }
+    std::string bytes;
+    std::rewind(file);
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) bytes.append(buffer, read);
+    std::fclose(file);
+    return bytes;
+}
+
+// Parses every lazy body through the document, as a runtime would on first
+// call. A body with a syntax error stays lazy.
+static void parse_bodies(IncrementalDocument& document) {
+    for (size_t i = 0; i < document.segment_count(); i++) {
+        for (const StmtPtr& statement : document.segment(i).statements) {
+            auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+            if (!function) continue;
+            try {
+                document.parse_function_body(i, *function);
+            } catch (const std::runtime_error&) {
+            }
+        }
+    }
+}
+
+// Tokens, text, segment boundaries and ASTs of `document` against a document
+// built from scratch for the same text.
+static bool matches_fresh(IncrementalDocument& document, bool lazy, const std::string& label) {
+    const std::string text = document.source();
+    IncrementalDocument fresh(text, lazy);
+    parse_bodies(document);
+    parse_bodies(fresh);
+
+    bool same = describe(document.tokens()) == describe(lex(text));
+    check(same, label + ": tokens match a fresh lex of \"" + text + "\"\n" + describe(document.tokens()));
+    bool segments = document.segment_count() == fresh.segment_count();
+    for (size_t i = 0; segments && i < fresh.segment_count(); i++) {
+        segments = document.segment(i).text == fresh.segment(i).text &&
+                   ast_dump(document.segment(i).statements) == ast_dump(fresh.segment(i).statements);
+    }
+    check(segments, label + ": segments and ASTs match a fresh parse of \"" + text + "\"");
+    return same && segments;
+}
+
+static std::string applied(std::string source, const TextEdit& edit) {
+    return source.replace(edit.offset, edit.removed, edit.inserted);
+}
+
+struct Case {
+    const char* source;
+    TextEdit edit;
+};
+
+// Edits that join, split or swallow tokens next to them.
+static const Case cases[] = {
+    {"let a = 1.;", {10, 0, "5"}},
+    {"let a = 1.5;", {10, 1, ""}},
+    {"let ab = 1;", {6, 0, "c"}},
+    {"let a = 1; let b = 2;", {10, 1, ""}},
+    {"let a = 1 / 2;\nlet b = 3;", {10, 1, "/"}},
+    {"let a = \"x\";\nlet b = 3;", {10, 1, ""}},
+    {"let a = 1; /* c */ let b = 2;", {17, 2, ""}},
+    {"let a = 1;\nlet b = 2;\nlet c = 3;", {0, 0, "\n\n"}},
+    {"let a = 1;\nlet b = 2;", {11, 10, "function f() { return 1; }"}},
+    {"let a = 1;", {10, 0, " let b = 2;"}},
+};
+
+static void relexing() {
+    for (const Case& test : cases) {
+        std::vector<Token> tokens = lex(test.source);
+        std::string edited = applied(test.source, test.edit);
+        relex(edited, tokens, test.edit);
+        check(describe(tokens) == describe(lex(edited)), "relex matches a fresh lex of \"" + edited + "\":\n" + describe(tokens));
+    }
+
+    std::vector<Token> tokens = lex("let a = 1;");
+    bool rejected = false;
+    try {
+        relex("let a = 1;x", tokens, TextEdit{12, 0, "x"});
+    } catch (const std::out_of_range&) {
+        rejected = true;
+    }
+    check(rejected, "an edit past the end is rejected");
+}
+
+static void documents() {
+    for (const Case& test : cases) {
+        for (bool lazy : {false, true}) {
+            IncrementalDocument document(test.source, lazy);
+            document.apply(test.edit);
+            check(document.source() == applied(test.source, test.edit), "the text takes the edit");
+            matches_fresh(document, lazy, lazy ? "lazy case" : "case");
+        }
+    }
+
+    // Segments the edit does not reach keep their nodes.
+    IncrementalDocument document("function f() { return 1; }\nlet a = 1;\nlet b = 2;\n");
+    const Statement* untouched = document.segment(0).statements[0].get();
+    document.apply(TextEdit{document.source().find("2"), 1, "3"});
+    check(document.segment(0).statements[0].get() == untouched, "an untouched declaration is reused");
+    check(document.start(2).line == 3 && document.start(2).offset == 38, "segment starts follow the text");
+
+    std::string before = document.source();
+    bool rejected = false;
+    try {
+        document.apply(TextEdit{before.size() - 1, 2, ""});
+    } catch (const std::out_of_range&) {
+        rejected = true;
+    }
+    check(rejected && document.source() == before, "an edit past the end is rejected and changes nothing");
+
+    rejected = false;
+    try {
+        document.apply(TextEdit{0, 0, "\xff"});
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    check(rejected && document.source() == before, "invalid UTF-8 is rejected and changes nothing");
+
+    IncrementalDocument emptied("let a = 1;");
+    emptied.apply(TextEdit{0, 10, ""});
+    check(emptied.segment_count() == 1 && emptied.tokens().size() == 1, "an emptied document keeps one segment");
+    emptied.apply(TextEdit{0, 0, "let b = 2;"});
+    matches_fresh(emptied, false, "refilled");
+}
+
+// Random small edits to a generated program, including the characters that
+// join statements, open blocks, strings and comments.
+static void random_edits() {
+    static const char* fragments[] = {"{", "}", "(", ")", ";", "\"", "/", "*", ".", "1", "5", "a", " ", "\n",
+                                      "let ", "function ", "memo ", "x = 2;", "/*", "*/", "//"};
+    // Most of these edits leave syntax errors; keep the parser's reports out
+    // of the output and pass on only the failed checks.
+    std::ostringstream reports;
+    std::streambuf* saved = std::cerr.rdbuf(reports.rdbuf());
+    struct Restore {
+        std::streambuf* saved;
+        ~Restore() { std::cerr.rdbuf(saved); }
+    } restore{saved};
+
+    std::mt19937 rng(42);
+    for (bool lazy : {false, true}) {
+        IncrementalDocument document(Generator(Shape::FUNCTIONS, 5).generate(4096), lazy);
+        for (int step = 0; step < 300; step++) {
+            size_t offset = rng() % (document.size() + 1);
+            size_t removed = rng() % 3 == 0 ? std::min<size_t>(rng() % 12, document.size() - offset) : 0;
+            std::string inserted = rng() % 4 == 0 ? "" : fragments[rng() % (sizeof(fragments) / sizeof(fragments[0]))];
+            document.apply(TextEdit{offset, removed, inserted});
+            if (!matches_fresh(document, lazy, "random edit " + std::to_string(step))) {
+                std::istringstream lines(reports.str());
+                for (std::string line; std::getline(lines, line);) {
+                    if (line.rfind("FAIL: ", 0) == 0) std::cout << line << "\n";
+                }
+                return;
+            }
+        }
+    }
+}
+
+int main() {
+    relexing();
+    documents();
+    random_edits();
+
+    if (failures) return 1;
+    std::cout << "incremental: ok\n";
+    return 0;
+}
@@ -0,0 +1,69 @@
+// MemoCache eviction order, re-insertion and hit/miss counts, keyed by
+// argument lists through ArgumentsHash.
+#include <iostream>
+#include <string>
+#include <vector>
+#include "MemoCache.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+using Arguments = std::vector<long>;
+using Cache = MemoCache<Arguments, long, ArgumentsHash<long>>;
+
+static void eviction() {
+    Cache cache(2);
+    cache.insert({1}, 10);
+    cache.insert({2}, 20);
+    check(cache.find({1}) && *cache.find({1}) == 10, "a stored result is found");
+
+    // {2} is now least recently used, so it goes first.
+    cache.insert({3}, 30);
+    check(cache.size() == 2, "the cache stays at capacity");
+    check(!cache.find({2}), "the least recently used entry is evicted");
+    check(cache.find({1}) && cache.find({3}), "the others stay");
+
+    // Re-inserting an existing key replaces it and makes it most recent.
+    cache.insert({3}, 31);
+    cache.insert({1}, 11);
+    cache.insert({4}, 40);
+    check(cache.size() == 2 && !cache.find({3}), "re-inserting refreshes recency");
+    check(cache.find({1}) && *cache.find({1}) == 11, "re-inserting replaces the value");
+
+    cache.clear();
+    check(cache.size() == 0 && !cache.find({1}), "clear() empties the cache");
+
+    Cache disabled(0);
+    disabled.insert({1}, 10);
+    check(disabled.size() == 0 && !disabled.find({1}), "a zero capacity caches nothing");
+}
+
+static void counting() {
+    Cache cache(4);
+    check(!cache.find({1, 2}), "an empty cache misses");
+    cache.insert({1, 2}, 3);
+    cache.find({1, 2});
+    cache.find({1, 2});
+    cache.find({2, 1});
+    check(cache.hits() == 2 && cache.misses() == 2, "hits and misses are counted: " + std::to_string(cache.hits()) + "/" +
+                                                        std::to_string(cache.misses()));
+
+    ArgumentsHash<long> hash;
+    check(hash({1, 2}) != hash({2, 1}), "argument order is part of the key");
+    check(hash({}) != hash({0}), "so is the argument count");
+}
+
+int main() {
+    eviction();
+    counting();
+
+    if (failures) return 1;
+    std::cout << "memo cache: ok\n";
+    return 0;
+}
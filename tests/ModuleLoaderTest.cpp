@@ -0,0 +1,97 @@
+// ModuleLoader import discovery, caching and per-module failures on a small
+// module tree in a temporary directory.
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include "ModuleLoader.hpp"
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+// Writes `source` and moves the mtime forward, so a rewrite within the
+// filesystem's timestamp granularity is still seen as a change.
+static void write(const fs::path& path, const std::string& source) {
+    bool existed = fs::exists(path);
+    auto before = existed ? fs::last_write_time(path) : fs::file_time_type();
+    std::ofstream(path, std::ios::binary) << source;
+    if (existed) fs::last_write_time(path, before + std::chrono::seconds(1));
+}
+
+static std::string name_of(const std::shared_ptr<const Module>& module) {
+    return fs::path(module->path).stem().string();
+}
+
+static std::string names(const std::vector<std::shared_ptr<const Module>>& modules) {
+    std::string out;
+    for (const auto& module : modules) out += (out.empty() ? "" : " ") + name_of(module);
+    return out;
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / ("agscript_modules_" + std::to_string(getpid()));
+    fs::create_directories(dir);
+
+    // The string and the (rejected) import inside f are not edges;
+    // missing.ajg does not exist.
+    write(dir / "main.ajg", "import \"lib\"; let s = \"import\"; function f() { import \"missing\"; return 1; }");
+    write(dir / "lib.ajg", "import \"util\"; let x = 1;");
+    write(dir / "util.ajg", "let u = 2;");
+
+    ModuleLoader loader(2);
+    std::vector<std::shared_ptr<const Module>> first;
+    try {
+        first = loader.load((dir / "main.ajg").string());
+    } catch (const std::exception& e) {
+        check(false, std::string("load: ") + e.what());
+    }
+    check(names(first) == "util lib main", "imports come before importers: " + names(first));
+    if (first.size() == 3) {
+        check(first[2]->imports.size() == 1, "only the top-level import of main is an edge");
+        check(first[2]->program.size() == 3, "main is parsed");
+        for (const auto& module : first) check(module->error.empty(), name_of(module) + " loads without error");
+
+        std::vector<std::shared_ptr<const Module>> again = loader.load((dir / "main.ajg").string());
+        check(again.size() == 3 && again[0] == first[0] && again[1] == first[1] && again[2] == first[2],
+              "an unchanged graph comes from the cache");
+
+        // Parsing does not read imports, so editing util leaves lib and main.
+        write(dir / "util.ajg", "let u = 3; let v = 4;");
+        std::vector<std::shared_ptr<const Module>> edited = loader.load((dir / "main.ajg").string());
+        check(edited.size() == 3 && edited[0] != first[0] && edited[0]->program.size() == 2, "an edited module is recompiled");
+        check(edited.size() == 3 && edited[1] == first[1] && edited[2] == first[2], "its importers are not");
+        check(first[0]->program.size() == 1, "an earlier handle keeps the version it saw");
+
+        // A bad module is reported on its own; the rest of the graph loads.
+        write(dir / "util.ajg", "let u = \"\xff\";");
+        std::vector<std::shared_ptr<const Module>> broken = loader.load((dir / "main.ajg").string());
+        check(broken.size() == 3 && !broken[0]->error.empty() && broken[0]->program.empty(), "invalid UTF-8 is reported on the module");
+        check(broken.size() == 3 && broken[1]->error.empty() && broken[2]->error.empty(), "the other modules still load");
+    }
+
+    write(dir / "util.ajg", "import \"main\"; let u = 2;");
+    bool cycle = false;
+    try {
+        loader.load((dir / "main.ajg").string());
+    } catch (const std::runtime_error&) {
+        cycle = true;
+    }
+    check(cycle, "an import cycle throws");
+
+    fs::remove_all(dir);
+
+    if (failures) return 1;
+    std::cout << "module loader: ok\n";
+    return 0;
+}
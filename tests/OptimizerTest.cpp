@@ -0,0 +1,188 @@
+// Optimizer and analysis passes on small programs, checked through their
+// reports and the --types dump.
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "passes/AstUtil.hpp"
+#include "passes/CommonSubexpression.hpp"
+#include "passes/DeadCode.hpp"
+#include "passes/Inliner.hpp"
+#include "passes/LoopInvariant.hpp"
+#include "passes/Purity.hpp"
+#include "passes/TypeInference.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+static std::vector<StmtPtr> parse(const std::string& source) {
+    return Parser(lex(source)).parse();
+}
+
+// The lexer has no '/' token, so sources spell divisions as '-' and they are
+// turned into DIVIDE nodes after parsing.
+static void divide(ExprPtr& expression) {
+    auto* binary = dynamic_cast<BinaryExpression*>(expression.get());
+    if (binary && binary->op == TokenType::SUBTRACT) binary->op = TokenType::DIVIDE;
+    for_each_child(*expression, divide);
+}
+
+static std::vector<StmtPtr> parse_divided(const std::string& source) {
+    auto program = parse(source);
+    for (auto& statement : program) {
+        if (statement) for_each_expression(*statement, divide);
+    }
+    return program;
+}
+
+static std::string cse(const std::string& source) {
+    auto program = parse(source);
+    std::ostringstream report;
+    CommonSubexpression(&report).run(program);
+    return report.str();
+}
+
+static std::string licm(std::vector<StmtPtr> program) {
+    std::ostringstream report;
+    LoopInvariant(&report).run(program);
+    return report.str();
+}
+
+static size_t inlined(const std::string& source) {
+    auto program = parse_divided(source);
+    return Inliner().run(program);
+}
+
+static size_t dead(const std::string& source) {
+    auto program = parse_divided(source);
+    return DeadCode().run(program);
+}
+
+static std::string cse_divided(const std::string& source) {
+    auto program = parse_divided(source);
+    std::ostringstream report;
+    CommonSubexpression(&report).run(program);
+    return report.str();
+}
+
+static std::string types(const std::string& source) {
+    auto program = parse(source);
+    TypeInference().run(program);
+    std::ostringstream out;
+    dump_types(program, out);
+    return out.str();
+}
+
+static std::string purity(const std::string& source) {
+    auto program = parse(source);
+    std::ostringstream report;
+    Purity(&report).run(program);
+    return report.str();
+}
+
+// Parses lazily, then runs Purity once with only `f` parsed and once with
+// every body parsed; returns both reports.
+static std::pair<std::string, std::string> purity_lazy(const std::string& source) {
+    std::vector<Token> tokens = lex(source);
+    Parser parser(tokens, true);
+    auto program = parser.parse();
+
+    std::ostringstream partial;
+    for (auto& statement : program) {
+        auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (function && function->name == "f") parser.parse_function_body(*function);
+    }
+    Purity(&partial).run(program);
+
+    std::ostringstream full;
+    for (auto& statement : program) {
+        if (auto* function = dynamic_cast<FunctionDeclaration*>(statement.get())) parser.parse_function_body(*function);
+    }
+    Purity(&full).run(program);
+    return {partial.str(), full.str()};
+}
+
+int main() {
+    std::string shared = cse("function f(x) { let a = x - 2 + 1; let b = x - 2 + 1; return a + b; }");
+    check(shared.find("cse: ((x - 2) + 1) computed once as __cse0 instead of 2 times in f") != std::string::npos,
+          "repeated local expression is shared:\n" + shared);
+
+    std::string local = cse("function f(x) { let a = x + 1; x = 5; let b = x + 1; return a + b; }");
+    check(local.empty(), "assigning a local splits its versions:\n" + local);
+
+    std::string global = cse("let g = 1; function h() { let a = g + 1; g = 5; let b = g + 1; return a + b; }");
+    check(global.empty(), "assigning a global splits its versions:\n" + global);
+
+    std::string call = cse("let g = 1; function k() { return 0; } function h() { let a = g + 1; k(); let b = g + 1; return a + b; }");
+    check(call.empty(), "a call splits the versions of every global:\n" + call);
+
+    std::string hoisted = licm(parse("function f(x, n) { let s = 0; while (n) { s = s + (x + 1); n = n + 1; } return s; }"));
+    check(hoisted == "licm: hoisted (x + 1) out of while loop in f as __licm0\n", "an invariant leaves the loop:\n" + hoisted);
+
+    std::string written = licm(parse("function f(x, n) { let s = 0; while (n) { s = s + (x + 1); x = n; } return s; }"));
+    check(written.empty(), "an input the loop assigns is not invariant:\n" + written);
+
+    std::string called = licm(parse("let g = 1; function k() { return 0; } function f(n) { while (n) { n = g + 1 + k(); } return n; }"));
+    check(called.empty(), "a call in the loop may change a global:\n" + called);
+
+    std::string topLevel = licm(parse("let x = 1; let n = 3; while (n) { n = x + 1; }"));
+    check(topLevel.empty(), "top-level loops are left alone:\n" + topLevel);
+
+    // A division may raise, so no pass drops, shares or moves it. Every '-'
+    // below is a division.
+    check(inlined("function k(x) { return 1; } function f(y) { return k(y + 1); }") == 1, "an unused pure argument is dropped");
+    check(inlined("function k(x) { return 1; } function f(y) { return k(1 - y); }") == 0, "an unused division argument is kept");
+    check(dead("function f(x) { let t = 1 - x; x + 1; 2 - x; return x; }") == 1, "dead code keeps divisions");
+    std::string moved = licm(parse_divided("function f(x, n) { while (n) { n = n + (1 - x); } return n; }"));
+    check(moved.empty(), "a division stays in the loop:\n" + moved);
+    std::string divided = cse_divided("function f(x) { let a = 1 - x + 1; let b = 1 - x + 1; return a + b; }");
+    check(divided.empty(), "a division is not shared:\n" + divided);
+
+    std::string direct = types("function f(x) { return x + 1; } let a = f(1); let b = f(2);");
+    check(direct.find("function f(x: int) -> int") != std::string::npos, "parameters join the call sites:\n" + direct);
+
+    std::string escaping = types("function f(x) { return x + 1; } function apply(g, v) { return g(v); } let a = f(1); let c = apply(f, \"s\");");
+    check(escaping.find("function f(x: dynamic)") != std::string::npos, "a function passed as a value has dynamic parameters:\n" + escaping);
+
+    std::string reassigned = types("let g = 1; g = \"s\"; function f() { let y = g + 1; return y; } let r = f();");
+    check(reassigned.find("let g: dynamic") != std::string::npos, "a top-level assignment widens the global:\n" + reassigned);
+    check(reassigned.find("let y: dynamic") != std::string::npos, "a local computed from it stays boxed:\n" + reassigned);
+
+    std::string statement = types("function h(x) { return x; } let a = h(1); h(\"str\");");
+    check(statement.find("function h(x: dynamic)") != std::string::npos, "a call in a top-level statement widens parameters:\n" + statement);
+
+    std::string impure = purity("let g = 1; memo function f(x) { return x + g; } g = 2;");
+    check(impure.find("memo: f is not pure (reads g)") != std::string::npos, "a top-level assignment makes a reader impure:\n" + impure);
+    std::string constant = purity("let g = 1; memo function f(x) { return x + g; } let h = f(2);");
+    check(constant.empty(), "a global nothing assigns is constant:\n" + constant);
+
+    auto writer = purity_lazy("let g = 1; memo function f(x) { return x + g; } function set() { g = 2; return 0; }");
+    check(writer.first.find("memo: f is not pure") != std::string::npos, "a lazy body may write the global f reads:\n" + writer.first);
+    check(writer.second.find("memo: f is not pure (reads g)") != std::string::npos, "once parsed, the write is seen:\n" + writer.second);
+
+    auto reader = purity_lazy("let g = 1; memo function f(x) { return x + g; } function get() { return g; }");
+    check(reader.first.find("memo: f is not pure") != std::string::npos, "nothing is pure while a body is lazy:\n" + reader.first);
+    check(reader.second.empty(), "f is pure once every body is parsed:\n" + reader.second);
+
+    if (failures) return 1;
+    std::cout << "optimizer: ok\n";
+    return 0;
+}
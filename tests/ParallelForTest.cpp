@@ -0,0 +1,139 @@
+// parallel_chunks, parallel_for and parallel_reduce on one- and four-thread
+// pools: chunk coverage, empty and one-element ranges, and each reduction.
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "ParallelFor.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+// Every index lands in exactly one chunk, and chunk `index` covers
+// [index * grain, min(count, (index + 1) * grain)).
+static void coverage(WorkerPool& pool, size_t count) {
+    const std::string label = std::to_string(pool.size()) + " threads, " + std::to_string(count) + " items";
+    std::vector<std::atomic<int>> visits(count);
+    std::mutex lock;
+    std::vector<std::pair<size_t, size_t>> chunks(parallel_chunk_count(count, pool.size()), {0, 0});
+    std::atomic<size_t> calls{0};
+
+    parallel_chunks(pool, count, [&](size_t index, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) visits[i]++;
+        std::lock_guard<std::mutex> guard(lock);
+        if (index < chunks.size()) chunks[index] = {begin, end};
+        calls++;
+    });
+
+    check(calls == chunks.size(), label + ": one call per chunk");
+    check(std::all_of(visits.begin(), visits.end(), [](const std::atomic<int>& v) { return v == 1; }),
+          label + ": every index is visited once");
+    size_t grain = parallel_grain(count, pool.size());
+    bool bounds = true;
+    for (size_t index = 0; index < chunks.size(); index++) {
+        bounds = bounds && chunks[index].first == index * grain && chunks[index].second == std::min(count, (index + 1) * grain);
+    }
+    check(bounds, label + ": chunk bounds follow the grain");
+}
+
+static void edges(WorkerPool& pool) {
+    const std::string label = std::to_string(pool.size()) + " threads";
+
+    bool called = false;
+    parallel_chunks(pool, 0, [&](size_t, size_t, size_t) { called = true; });
+    parallel_for(pool, 0, [&](size_t, size_t) { called = true; });
+    check(!called, label + ": an empty range runs nothing");
+    int empty = parallel_reduce(pool, 0, 7, [&](size_t, size_t) { called = true; return 0; },
+                                [](int a, int b) { return a + b; });
+    check(!called && empty == 7, label + ": an empty reduction is its identity");
+
+    std::vector<std::pair<size_t, size_t>> one;
+    parallel_chunks(pool, 1, [&](size_t index, size_t begin, size_t end) { one.push_back({index, begin * 10 + end}); });
+    check(one.size() == 1 && one[0].first == 0 && one[0].second == 1, label + ": one element is one chunk [0, 1)");
+    int single = parallel_reduce(pool, 1, 0, [](size_t begin, size_t end) { return (int)(end - begin) * 5; },
+                                 [](int a, int b) { return a + b; });
+    check(single == 5, label + ": a one-element reduction");
+}
+
+static void reductions(WorkerPool& pool) {
+    const std::string label = std::to_string(pool.size()) + " threads";
+    const size_t count = 10007;
+    std::vector<long> values(count);
+    for (size_t i = 0; i < count; i++) values[i] = (long)((i * 7919) % 10007) - 5000;
+
+    long sum = parallel_reduce(
+        pool, count, 0L,
+        [&](size_t begin, size_t end) { return std::accumulate(values.begin() + begin, values.begin() + end, 0L); },
+        [](long a, long b) { return a + b; });
+    check(sum == std::accumulate(values.begin(), values.end(), 0L), label + ": sum");
+
+    long min = parallel_reduce(
+        pool, count, std::numeric_limits<long>::max(),
+        [&](size_t begin, size_t end) { return *std::min_element(values.begin() + begin, values.begin() + end); },
+        [](long a, long b) { return std::min(a, b); });
+    check(min == *std::min_element(values.begin(), values.end()), label + ": min");
+
+    long max = parallel_reduce(
+        pool, count, std::numeric_limits<long>::min(),
+        [&](size_t begin, size_t end) { return *std::max_element(values.begin() + begin, values.begin() + end); },
+        [](long a, long b) { return std::max(a, b); });
+    check(max == *std::max_element(values.begin(), values.end()), label + ": max");
+
+    std::vector<long> appended = parallel_reduce(
+        pool, count, std::vector<long>(),
+        [&](size_t begin, size_t end) { return std::vector<long>(values.begin() + begin, values.begin() + end); },
+        [](std::vector<long> a, std::vector<long> b) {
+            a.insert(a.end(), b.begin(), b.end());
+            return a;
+        });
+    check(appended == values, label + ": append keeps source order");
+}
+
+static void failures_and_nesting(WorkerPool& pool) {
+    const std::string label = std::to_string(pool.size()) + " threads";
+
+    bool rethrown = false;
+    try {
+        parallel_for(pool, 1000, [](size_t begin, size_t end) {
+            if (begin <= 500 && 500 < end) throw std::runtime_error("chunk");
+        });
+    } catch (const std::runtime_error& e) {
+        rethrown = std::string(e.what()) == "chunk";
+    }
+    check(rethrown, label + ": a chunk's exception reaches the caller");
+
+    // The caller drains chunks itself, so a loop inside a job finishes even
+    // when that job holds the only worker.
+    std::promise<long> nested;
+    pool.submit([&]() {
+        nested.set_value(parallel_reduce(pool, 100, 0L, [](size_t begin, size_t end) { return (long)(end - begin); },
+                                         [](long a, long b) { return a + b; }));
+    });
+    check(nested.get_future().get() == 100, label + ": a loop inside a pool job");
+}
+
+int main() {
+    for (unsigned threads : {1u, 4u}) {
+        WorkerPool pool(threads);
+        for (size_t count : {1, 2, 7, 31, 32, 33, 1000, 10007}) coverage(pool, count);
+        edges(pool);
+        reductions(pool);
+        failures_and_nesting(pool);
+    }
+
+    if (failures) return 1;
+    std::cout << "parallel for: ok\n";
+    return 0;
+}
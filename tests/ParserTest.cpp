@@ -0,0 +1,94 @@
+// Parser::parse_parallel against a sequential parse of the bench shapes,
+// compared through their binary AST dumps.
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "Dump.hpp"
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "WorkerPool.hpp"
+#include "bench/Generator.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+static std::string ast_dump(const std::vector<StmtPtr>& program) {
+    FILE* file = std::tmpfile();
+    {
+        OutputBuffer out(fileno(file));
+        dump_ast_binary(program, out);
+        out.flush();
+    }
+    std::string bytes;
+    std::rewind(file);
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) bytes.append(buffer, read);
+    std::fclose(file);
+    return bytes;
+}
+
+static void shapes(WorkerPool& pool, bool lazy) {
+    for (size_t i = 0; i < (size_t)Shape::COUNT; i++) {
+        const std::string label = std::string(shape_name((Shape)i)) + (lazy ? " (lazy)" : "");
+        std::vector<Token> tokens = lex(Generator((Shape)i, 7).generate(256 * 1024));
+
+        std::string sequential = ast_dump(Parser(tokens, lazy).parse());
+        ParallelProgram parallel = Parser::parse_parallel(tokens, pool, lazy);
+        check(parallel.arenas.size() == pool.size() + 1, label + ": one arena per thread");
+        check(ast_dump(parallel.statements) == sequential, label + ": parallel AST matches parse()");
+    }
+}
+
+static void budgets(WorkerPool& pool) {
+    std::vector<Token> tokens = lex(Generator(Shape::FUNCTIONS, 3).generate(256 * 1024));
+
+    TrackingAllocator tracker;
+    {
+        AllocatorScope scope(tracker);
+        ParallelProgram program = Parser::parse_parallel(tokens, pool);
+        check(tracker.live() > 0, "arena blocks come from the caller's allocator");
+    }
+    check(tracker.live() == 0, "dropping the program returns every block");
+
+    TrackingAllocator small(default_allocator(), 100 * 1024);
+    bool exceeded = false;
+    try {
+        AllocatorScope scope(small);
+        Parser::parse_parallel(tokens, pool);
+    } catch (const MemoryBudgetExceeded&) {
+        exceeded = true;
+    }
+    check(exceeded, "a worker's MemoryBudgetExceeded reaches the caller");
+    check(small.live() == 0, "a failed parse returns every block");
+}
+
+int main() {
+    WorkerPool pool(3);
+    shapes(pool, false);
+    shapes(pool, true);
+    budgets(pool);
+
+    if (failures) return 1;
+    std::cout << "parser: ok\n";
+    return 0;
+}
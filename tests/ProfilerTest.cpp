@@ -0,0 +1,83 @@
+// Drives Profiler::enter/leave the way the runtime's call path will and
+// checks the collapsed stacks that come out.
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "Profiler.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::vector<StmtPtr> parse(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return Parser(tokens).parse();
+}
+
+// Spins on CPU time, which is what ITIMER_PROF counts.
+static void burn(std::chrono::milliseconds duration) {
+    auto until = std::chrono::steady_clock::now() + duration;
+    volatile unsigned long sink = 0;
+    while (std::chrono::steady_clock::now() < until) sink = sink + 1;
+}
+
+int main() {
+    std::string source = "function outer() {\n    return 1;\n}\nfunction inner() {\n    return 2;\n}\n";
+    auto program = parse(source);
+    auto& outer = static_cast<FunctionDeclaration&>(*program[0]);
+    auto& inner = static_cast<FunctionDeclaration&>(*program[1]);
+
+    Profiler profiler(997);
+    check(profiler.start(), "profiler starts");
+    check(!Profiler(997).start(), "a second profiler is refused while one runs");
+
+    std::thread worker([&]() {
+        ProfileScope scope(inner);
+        burn(std::chrono::milliseconds(200));
+    });
+    {
+        ProfileScope outerScope(outer);
+        ProfileScope innerScope(inner);
+        burn(std::chrono::milliseconds(200));
+    }
+    worker.join();
+    profiler.stop();
+
+    // Frames hold copies of the names, so the AST can go first.
+    program.clear();
+
+    std::ostringstream out;
+    profiler.write_collapsed(out);
+    std::string collapsed = out.str();
+    check(profiler.samples() > 0, "samples were taken");
+    check(collapsed.find("<script>;outer:1;inner:4 ") != std::string::npos, "nested stack on the main thread:\n" + collapsed);
+    check(collapsed.find("<script>;inner:4 ") != std::string::npos, "separate stack on the worker thread:\n" + collapsed);
+
+    // Stopping while signals are in flight must leave nothing writing into a
+    // destroyed profiler, and a pending SIGPROF must not kill the process.
+    for (int i = 0; i < 50; i++) {
+        Profiler shortLived(4999);
+        check(shortLived.start(), "short-lived profiler starts");
+        burn(std::chrono::milliseconds(2));
+    }
+    burn(std::chrono::milliseconds(20));
+
+    if (failures) return 1;
+    std::cout << "profiler: ok\n";
+    return 0;
+}
@@ -0,0 +1,168 @@
+// Snapshot images written, mapped and loaded back against a fresh lex and
+// parse of the same source, and rejected when corrupt.
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "Dump.hpp"
+#include "Parser.hpp"
+#include "Snapshot.hpp"
+
+namespace fs = std::filesystem;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+static std::string describe(const std::vector<Token>& tokens) {
+    std::string out;
+    for (const Token& token : tokens) {
+        out += std::to_string((int)token.type) + " '" + token.value + "' " + std::to_string(token.line) + ":" +
+               std::to_string(token.column) + "@" + std::to_string(token.offset) + "\n";
+    }
+    return out;
+}
+
+static std::string ast_dump(const std::vector<StmtPtr>& program) {
+    FILE* file = std::tmpfile();
+    {
+        OutputBuffer out(fileno(file));
+        dump_ast_binary(program, out);
+        out.flush();
+    }
+    std::string bytes;
+    std::rewind(file);
+    char buffer[4096];
+    size_t read;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) bytes.append(buffer, read);
+    std::fclose(file);
+    return bytes;
+}
+
+static std::string read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::string& path, const std::string& bytes) {
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+}
+
+static const char* prelude =
+    "let limit = 10;\n"
+    "limit = limit + 1;\n"
+    "function add(a, b) { return a + b; }\n"
+    "memo function twice(x) { let y = add(x, x); return y; }\n"
+    "function count(n) { let s = 0; while (n) { s = s + n; n = n - 1; } return s; }\n";
+
+static void round_trip(const std::string& path) {
+    std::vector<Token> tokens = lex(prelude);
+    write_snapshot(path, tokens);
+
+    Snapshot image(path);
+    check(image.header().functionCount == 3, "every top-level function is in the table");
+    check(describe(image.load_tokens()) == describe(tokens), "load_tokens() gives back the lexed stream");
+
+    // Lazily: only the tokens outside bodies, then one body on first use.
+    std::vector<Token> loaded = image.load_tokens(false);
+    std::vector<StmtPtr> program = image.load_program(loaded);
+    size_t lazy = 0;
+    for (auto& statement : program) {
+        auto* function = dynamic_cast<FunctionDeclaration*>(statement.get());
+        if (!function) continue;
+        check(function->isLazy(), function->name + " comes back lazy");
+        check(loaded[function->bodyBegin].type != TokenType::LEFT_BRACE, function->name + "'s body tokens are not decoded yet");
+        lazy++;
+
+        image.load_token_range(loaded, function->bodyBegin, function->bodyEnd);
+        Parser(loaded, true).parse_function_body(*function);
+        check(!function->isLazy(), function->name + " parses from the image");
+    }
+    check(lazy == 3, "three lazy functions");
+    check(program.size() == 5 && dynamic_cast<FunctionDeclaration*>(program[3].get())->memoize, "memo survives the image");
+    check(ast_dump(program) == ast_dump(Parser(tokens).parse()), "the loaded program matches a fresh parse");
+}
+
+// Rewrites `bytes` of the image at `offset` and expects Snapshot to refuse it.
+static void corrupt(const std::string& path, const std::string& image, size_t offset, const void* bytes, size_t size,
+                    const std::string& what) {
+    std::string damaged = image;
+    std::memcpy(&damaged[offset], bytes, size);
+    write_file(path, damaged);
+
+    bool rejected = false;
+    try {
+        Snapshot snapshot(path);
+    } catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    check(rejected, what + " is rejected");
+}
+
+static void corruption(const std::string& path) {
+    write_snapshot(path, lex(prelude));
+    const std::string image = read_file(path);
+    SnapshotHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+
+    corrupt(path, image, 0, "XXSNAP\0\0", 8, "a bad magic");
+    uint32_t version = SNAPSHOT_VERSION + 1;
+    corrupt(path, image, offsetof(SnapshotHeader, version), &version, sizeof(version), "another version");
+    uint32_t tokens = UINT32_MAX;
+    corrupt(path, image, offsetof(SnapshotHeader, tokenCount), &tokens, sizeof(tokens), "a token table past the end");
+    uint64_t misaligned = header.functions + 1;
+    corrupt(path, image, offsetof(SnapshotHeader, functions), &misaligned, sizeof(misaligned), "a misaligned table");
+
+    uint32_t bodyEnd = header.tokenCount + 1;
+    corrupt(path, image, header.functions + offsetof(FunctionRecord, bodyEnd), &bodyEnd, sizeof(bodyEnd),
+            "a body past the last token");
+    uint32_t parameters = header.parameterCount + 1;
+    corrupt(path, image, header.functions + offsetof(FunctionRecord, parameterCount), &parameters, sizeof(parameters),
+            "a parameter range past the table");
+    int32_t function = (int32_t)header.functionCount;
+    corrupt(path, image, header.declarations + offsetof(DeclarationRecord, function), &function, sizeof(function),
+            "a declaration naming a missing function");
+
+    write_file(path, image.substr(0, image.size() / 2));
+    bool truncated = false;
+    try {
+        Snapshot snapshot(path);
+    } catch (const std::runtime_error&) {
+        truncated = true;
+    }
+    check(truncated, "a truncated image is rejected");
+}
+
+int main() {
+    std::string path = (fs::temp_directory_path() / ("agscript_snapshot_" + std::to_string(getpid()) + ".img")).string();
+    round_trip(path);
+    corruption(path);
+    fs::remove(path);
+
+    if (failures) return 1;
+    std::cout << "snapshot: ok\n";
+    return 0;
+}
@@ -0,0 +1,205 @@
+// UTF-8 validation and decoding, the XID tables, and how the lexer uses them
+// for identifiers and bad input.
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Lexer.hpp"
+#include "Utf8.hpp"
+#include "Xid.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::string hex(const std::string& bytes) {
+    static const char digits[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char byte : bytes) {
+        out += out.empty() ? "" : " ";
+        out += digits[byte >> 4];
+        out += digits[byte & 15];
+    }
+    return out;
+}
+
+static size_t invalid_offset(const std::string& bytes) {
+    return utf8_invalid_offset(bytes.data(), bytes.size());
+}
+
+struct Sequence {
+    const char* bytes;
+    char32_t code; // for valid sequences
+};
+
+static const Sequence valid[] = {
+    {"\x7F", 0x7F},         {"\xC2\x80", 0x80},         {"\xDF\xBF", 0x7FF},
+    {"\xE0\xA0\x80", 0x800}, {"\xED\x9F\xBF", 0xD7FF},  {"\xEE\x80\x80", 0xE000},
+    {"\xEF\xBF\xBF", 0xFFFF}, {"\xF0\x90\x80\x80", 0x10000}, {"\xF4\x8F\xBF\xBF", 0x10FFFF},
+};
+
+static const char* const invalid[] = {
+    // Stray continuation bytes and leads that never start a sequence.
+    "\x80", "\xBF", "\xF5\x80\x80\x80", "\xFF",
+    // Overlong forms.
+    "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF", "\xF0\x80\x80\x80", "\xF0\x8F\xBF\xBF",
+    // Surrogates.
+    "\xED\xA0\x80", "\xED\xBF\xBF",
+    // Past U+10FFFF.
+    "\xF4\x90\x80\x80",
+    // A lead followed by too few continuation bytes.
+    "\xC3" "A", "\xE2\x82" "A", "\xF0\x9F\x98" "A",
+};
+
+static void sequences() {
+    for (const Sequence& sequence : valid) {
+        std::string bytes = sequence.bytes;
+        size_t length = 0;
+        char32_t code = utf8_decode(bytes.data(), length);
+        check(invalid_offset(bytes) == bytes.size(), hex(bytes) + " is valid");
+        check(code == sequence.code && length == bytes.size(), hex(bytes) + " decodes to its code point");
+    }
+    for (const char* sequence : invalid) {
+        check(invalid_offset(sequence) == 0, hex(sequence) + " is rejected at its lead byte");
+    }
+
+    // Truncated at the end of the buffer rather than by another byte.
+    for (const char* truncated : {"\xC3", "\xE2\x82", "\xF0\x9F\x98"}) {
+        check(invalid_offset(std::string("ab") + truncated) == 2, hex(truncated) + " at the end is rejected");
+    }
+}
+
+// The vector path skips ASCII 16 bytes at a time, so put each sequence at
+// every offset around one and two blocks: the offending byte must be found
+// whether it starts a block, ends one, or straddles the boundary.
+static void blocks() {
+    for (size_t at = 0; at < 40; at++) {
+        for (size_t tail : {0, 1, 17}) {
+            for (const Sequence& sequence : valid) {
+                std::string bytes = std::string(at, 'a') + sequence.bytes + std::string(tail, 'b');
+                check(invalid_offset(bytes) == bytes.size(), hex(sequence.bytes) + " valid at offset " + std::to_string(at));
+            }
+            for (const char* sequence : invalid) {
+                std::string bytes = std::string(at, 'a') + sequence + std::string(tail, 'b');
+                check(invalid_offset(bytes) == at, hex(sequence) + " rejected at offset " + std::to_string(at));
+            }
+        }
+
+        // A valid sequence before the bad one moves the scan off the block
+        // grid; it has to pick up again and still stop at the right byte.
+        std::string bytes = std::string(at, 'a') + "\xC3\xA9" + std::string(20, 'b') + "\xED\xA0\x80";
+        check(invalid_offset(bytes) == at + 22, "a surrogate after é and ASCII at offset " + std::to_string(at));
+    }
+    check(invalid_offset("") == 0, "an empty buffer is valid");
+    check(invalid_offset(std::string(64, 'x')) == 64, "all-ASCII blocks are valid");
+}
+
+template <size_t N>
+static bool ordered(const XidRange (&ranges)[N]) {
+    for (size_t i = 0; i < N; i++) {
+        if (ranges[i].first > ranges[i].last || (i > 0 && ranges[i].first <= ranges[i - 1].last)) return false;
+    }
+    return ranges[0].first >= 0x80 && ranges[N - 1].last <= 0x10FFFF;
+}
+
+static void tables() {
+    check(ordered(xidStartRanges), "XID_Start ranges are sorted, disjoint and non-ASCII");
+    check(ordered(xidContinueRanges), "XID_Continue ranges are sorted, disjoint and non-ASCII");
+
+    // Both ends of every range are in it; the code points just outside are
+    // not, unless the next range starts there.
+    bool edges = true;
+    for (size_t i = 0; i < std::size(xidStartRanges); i++) {
+        const XidRange& range = xidStartRanges[i];
+        bool adjacent = i + 1 < std::size(xidStartRanges) && xidStartRanges[i + 1].first == range.last + 1;
+        edges = edges && xid_start(range.first) && xid_start(range.last) && !xid_start(range.first - 1) &&
+                (adjacent || !xid_start(range.last + 1));
+    }
+    check(edges, "xid_start() at the edges of every range");
+
+    bool subset = true;
+    for (char32_t code = 0x80; code <= 0x10FFFF && subset; code++) subset = !xid_start(code) || xid_continue(code);
+    check(subset, "every XID_Start code point is XID_Continue");
+
+    struct Property {
+        char32_t code;
+        bool start;
+        bool proceed;
+    };
+    const Property properties[] = {
+        {0xA9, false, false},    // ©
+        {0xAA, true, true},      // ª, first start range
+        {0xB7, false, true},     // middle dot
+        {0xE9, true, true},      // é
+        {0x300, false, true},    // combining grave accent
+        {0x3B1, true, true},     // α
+        {0x660, false, true},    // Arabic-Indic digit zero
+        {0x2028, false, false},  // line separator
+        {0x4E00, true, true},    // first CJK ideograph
+        {0xD800, false, false},  // surrogate
+        {0x1F600, false, false}, // emoji
+        {0x3134A, true, true},   // last start range
+        {0xE0100, false, true},  // variation selector
+        {0xE01EF, false, true},
+        {0xE01F0, false, false},
+        {0x10FFFF, false, false},
+    };
+    for (const Property& property : properties) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "U+%04X", (unsigned)property.code);
+        check(xid_start(property.code) == property.start, std::string(label) + " XID_Start");
+        check(xid_continue(property.code) == property.proceed, std::string(label) + " XID_Continue");
+    }
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+static void lexer() {
+    std::vector<Token> tokens = lex("let caf\xC3\xA9 = \xE5\x8F\x98\xE9\x87\x8F + a\xCC\x80;");
+    check(tokens.size() == 8 && tokens[1].type == TokenType::IDENTIFIER && tokens[1].value == "caf\xC3\xA9",
+          "an identifier ending in é");
+    check(tokens.size() == 8 && tokens[3].type == TokenType::IDENTIFIER && tokens[3].column == 12,
+          "a CJK identifier, columns counted in code points");
+    check(tokens.size() == 8 && tokens[5].value == "a\xCC\x80", "a combining mark continues an identifier");
+
+    tokens = lex("\xCC\x80" "a \xE2\x82\xAC");
+    check(tokens.size() == 4 && tokens[0].type == TokenType::UNKNOWN && tokens[0].value == "\xCC\x80",
+          "a combining mark cannot start an identifier");
+    check(tokens.size() == 4 && tokens[2].type == TokenType::UNKNOWN && tokens[2].value == "\xE2\x82\xAC",
+          "a non-XID code point is one UNKNOWN token");
+
+    std::string where;
+    try {
+        lex("let \xC3\xA9 = 1;\n" + std::string(20, ' ') + "\xED\xA0\x80;");
+    } catch (const std::runtime_error& e) {
+        where = e.what();
+    }
+    check(where == "Invalid UTF-8 at line 2, column 21", "the lexer reports where the input stops being valid: " + where);
+}
+
+int main() {
+    sequences();
+    blocks();
+    tables();
+    lexer();
+
+    if (failures) return 1;
+    std::cout << "utf8: ok\n";
+    return 0;
+}
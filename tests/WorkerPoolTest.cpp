@@ -0,0 +1,97 @@
+// WorkerPool scheduling, failure reporting and per-worker allocators.
+#include <atomic>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Lexer.hpp"
+#include "Parser.hpp"
+#include "WorkerPool.hpp"
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAIL: " << what << "\n";
+        failures++;
+    }
+}
+
+static std::vector<Token> lex(const std::string& source) {
+    Lexer lexer(source);
+    std::vector<Token> tokens;
+    Token token;
+    do {
+        token = lexer.getNextToken();
+        tokens.push_back(token);
+    } while (token.type != TokenType::END_OF_FILE);
+    return tokens;
+}
+
+static void scheduling() {
+    WorkerPool pool(4);
+    std::atomic<int> ran{0};
+    // Many short rounds, so submit() racing a worker's take() is exercised.
+    for (int round = 0; round < 200; round++) {
+        for (int i = 0; i < 16; i++) {
+            pool.submit([&]() {
+                ran++;
+                if (ran % 4 == 0) pool.submit([&]() { ran++; });
+            });
+        }
+        pool.wait();
+    }
+    check(ran >= 200 * 16, "every job runs, nested ones included: " + std::to_string(ran.load()));
+
+    pool.submit([]() { throw std::runtime_error("job failed"); });
+    bool rethrown = false;
+    try {
+        pool.wait();
+    } catch (const std::runtime_error& e) {
+        rethrown = std::string(e.what()) == "job failed";
+    }
+    check(rethrown, "wait() rethrows a job's exception");
+
+    std::atomic<bool> refused{false};
+    pool.submit([&]() {
+        try {
+            pool.wait();
+        } catch (const std::logic_error&) {
+            refused = true;
+        }
+    });
+    pool.wait();
+    check(refused, "wait() from inside a job throws std::logic_error");
+}
+
+static void allocators() {
+    WorkerPool pool(2);
+    std::vector<Token> tokens = lex("function f(x) { return x + 1; } let a = f(2);");
+    std::atomic<int> scoped{0};
+    for (int i = 0; i < 8; i++) {
+        pool.submit([&]() {
+            int worker = WorkerPool::current_worker();
+            if (&current_allocator() == &pool.memory(worker)) scoped++;
+            auto program = Parser(tokens).parse();
+        });
+    }
+    pool.wait();
+    check(scoped == 8, "jobs allocate from their worker's allocator");
+
+    size_t allocations = 0;
+    for (unsigned i = 0; i < pool.size(); i++) {
+        allocations += pool.memory(i).allocations(Phase::READ);
+        check(pool.memory(i).live() == 0, "worker " + std::to_string(i) + " freed every node");
+    }
+    check(allocations > 0, "nodes parsed in jobs are counted per worker");
+    check(&current_allocator() == &default_allocator(), "the caller's allocator is untouched");
+}
+
+int main() {
+    scheduling();
+    allocators();
+
+    if (failures) return 1;
+    std::cout << "worker pool: ok\n";
+    return 0;
+}